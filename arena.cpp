@@ -0,0 +1,75 @@
+#include <cstring>
+#include <new>
+#include "arena.hpp"
+#include "memstats.hpp"
+
+namespace lake{
+
+//Header at the front of every block, linking it to the block
+// allocated before it
+class Arena::Block{
+public:
+	Block * prev;
+	alignas(std::max_align_t) char data[1];
+};
+
+Arena::Arena(size_t blockSizeIn)
+: blockSize(blockSizeIn), head(nullptr), cur(nullptr), end(nullptr),
+  used(0), blocks(0){ }
+
+Arena::~Arena(){
+	release();
+}
+
+void * Arena::allocateSlow(size_t size, size_t align){
+	//Oversized requests get a block of their own so they do not
+	// waste the rest of the current block
+	size_t payload = blockSize;
+	if (size + align > blockSize / 4){ payload = size + align; }
+	size_t total = offsetof(Block, data) + payload;
+	Block * block = static_cast<Block *>(::operator new(total));
+	MemStats::recordArenaBlock(total);
+	block->prev = head;
+	head = block;
+	blocks++;
+
+	char * start = block->data;
+	char * stop = block->data + payload;
+	size_t pad = (align - reinterpret_cast<size_t>(start) % align) % align;
+	void * res = start + pad;
+	if (payload == blockSize){
+		cur = start + pad + size;
+		end = stop;
+	}
+	used += size;
+	return res;
+}
+
+const char * Arena::copyString(const char * str, size_t len){
+	char * res = static_cast<char *>(allocate(len + 1, 1));
+	memcpy(res, str, len);
+	res[len] = '\0';
+	return res;
+}
+
+void Arena::release(){
+	while (head != nullptr){
+		Block * prev = head->prev;
+		::operator delete(head);
+		head = prev;
+	}
+	cur = nullptr;
+	end = nullptr;
+	used = 0;
+	blocks = 0;
+}
+
+} //End namespace lake
+
+void * operator new(size_t size, lake::Arena& arena){
+	return arena.allocate(size);
+}
+
+void operator delete(void *, lake::Arena&){
+	//Arena memory is only reclaimed in bulk
+}
@@ -0,0 +1,56 @@
+#ifndef LAKE_ARENA_HPP
+#define LAKE_ARENA_HPP
+
+#include <cstddef>
+
+namespace lake{
+
+//A bump allocator. Objects placed in an arena are never freed
+// one at a time: all of their memory goes away at once when the
+// arena is released or destroyed, and no destructors are run, so
+// only objects that own no other resources should live here.
+class Arena{
+public:
+	Arena(size_t blockSizeIn = 64 * 1024);
+	~Arena();
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	void * allocate(size_t size, size_t align = alignof(std::max_align_t)){
+		size_t pad = (align - reinterpret_cast<size_t>(cur) % align) % align;
+		if (cur == nullptr || size + pad > static_cast<size_t>(end - cur)){
+			return allocateSlow(size, align);
+		}
+		void * res = cur + pad;
+		cur += pad + size;
+		used += size;
+		return res;
+	}
+
+	//Copy len bytes into the arena, adding a terminating NUL
+	const char * copyString(const char * str, size_t len);
+
+	//Free every block at once
+	void release();
+
+	//Bytes handed out, and the number of blocks backing them
+	size_t bytesUsed() const { return used; }
+	size_t blockCount() const { return blocks; }
+private:
+	class Block;
+	void * allocateSlow(size_t size, size_t align);
+	size_t blockSize;
+	Block * head;
+	char * cur;
+	char * end;
+	size_t used;
+	size_t blocks;
+};
+
+} //End namespace lake
+
+//Place an object in an arena: new (arena) Thing(...)
+void * operator new(size_t size, lake::Arena& arena);
+void operator delete(void * ptr, lake::Arena& arena);
+
+#endif
@@ -2,15 +2,28 @@
 
 namespace lake {
 
-ASTNode::ASTNode(size_t lineIn, size_t colIn){
-	this->line = lineIn;
-	this->col = colIn;
+static thread_local size_t nodesConstructed = 0;
+//The value of nodesConstructed when IDs were last restarted
+static thread_local size_t idBase = 0;
+
+ASTNode::ASTNode(NodeKind kindIn, size_t lineIn, size_t colIn)
+: loc(SourceManager::current().encode(lineIn, colIn)), 
+  id(nextID()), kind(kindIn){ }
+uint32_t ASTNode::nextID(){ 
+	return static_cast<uint32_t>(nodesConstructed++ - idBase); 
 }
+void ASTNode::restartIDs(){ idBase = nodesConstructed; }
+size_t ASTNode::idBound(){ return nodesConstructed - idBase; }
+size_t ASTNode::constructed(){ return nodesConstructed; }
 void ASTNode::doIndent(std::ostream& out, int indent){
 	for (int k = 0 ; k < indent; k++){ out << " "; }
 }
-size_t ASTNode::getLine(){ return line; }
-size_t ASTNode::getCol(){ return col; }
+size_t ASTNode::getLine(){ 
+	return SourceManager::current().line(loc); 
+}
+size_t ASTNode::getCol(){ 
+	return SourceManager::current().col(loc); 
+}
 std::string ASTNode::getPosition(){
 	std::string res = "";
 	res += std::to_string(getLine());
@@ -20,16 +33,15 @@ std::string ASTNode::getPosition(){
 }
 
 IdNode::IdNode(IDToken * token)
-: ExpNode(token->_line, token->_column), 
-  myStrVal(token->value()),
+: ExpNode(ID_NODE, token->_line, token->_column), 
+  myName(token->id()),
   mySymbol(NULL){ }
 
-std::string IdNode::getString(){ return myStrVal; }
-
-DeclNode::DeclNode(size_t lIn, size_t cIn, IdNode * idIn)
-: ASTNode(lIn, cIn), myID(idIn){ }
+const std::string& IdNode::getString(){ 
+	return Interner::name(myName); 
+}
 
-std::string DeclNode::getDeclaredName(){
+const std::string& DeclNode::getDeclaredName(){
 	return myID->getString();
 }
 
@@ -38,16 +50,30 @@ IdNode * DeclNode::getDeclaredID(){
 }
 
 ProgramNode::ProgramNode(DeclListNode * declListIn)
-: ASTNode(0,0), myDeclList(declListIn){ }
+: ASTNode(PROGRAM_NODE, NO_LOC), myDeclList(declListIn){ }
 
-TypeNode::TypeNode(size_t lnIn, size_t colIn)
-: ASTNode(lnIn, colIn){}
+TypeNode::TypeNode(NodeKind kindIn, size_t lnIn, size_t colIn)
+: ASTNode(kindIn, lnIn, colIn){}
 
 void TypeNode::setPtrDepth(size_t depth){
 	myPtrDepth = depth;
 }
 
 DerefNode::DerefNode(size_t lnIn, size_t colIn, ExpNode * tgt)
-: ExpNode(lnIn, colIn), myTgt(tgt){ }
+: ExpNode(DEREF_NODE, lnIn, colIn), myTgt(tgt){ }
+
+uint32_t ExpNode::mixHash(uint32_t hash, uint32_t value){
+	return hash ^ (value + 0x9e3779b9u + (hash << 6) + (hash >> 2));
+}
+
+//FNV-1a
+uint32_t ExpNode::textHash(const char * text, size_t length){
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0 ; i < length ; i++){
+		hash ^= static_cast<unsigned char>(text[i]);
+		hash *= 16777619u;
+	}
+	return hash;
+}
 
 } //End namespace lake
@@ -6,6 +6,9 @@
 #include <string.h>
 #include <list>
 #include "err.hpp"
+#include "memstats.hpp"
+#include "seq.hpp"
+#include "source_manager.hpp"
 #include "tokens.hpp"
 #include "types.hpp"
 
@@ -30,38 +33,80 @@ class TypeNode;
 class ExpNode;
 class IdNode;
 
-class ASTNode{
-public:
-	ASTNode(size_t lineIn, size_t colIn);
-	virtual void unparse(std::ostream&, int) = 0;
+//The concrete class of a node, so that passes can switch on it
+// (see ASTVisitor) instead of making a virtual call
+enum NodeKind{
+	PROGRAM_NODE, DECL_LIST_NODE, VAR_DECL_LIST_NODE, FORMALS_LIST_NODE,
+	EXP_LIST_NODE, STMT_LIST_NODE, FN_BODY_NODE,
+	VAR_DECL_NODE, FORMAL_DECL_NODE, FN_DECL_NODE,
+	INT_NODE, BOOL_NODE, VOID_NODE,
+	DEREF_NODE, ID_NODE, INT_LIT_NODE, STR_LIT_NODE, TRUE_NODE,
+	FALSE_NODE, ASSIGN_NODE, CALL_EXP_NODE, UNARY_MINUS_NODE, NOT_NODE,
+	PLUS_NODE, MINUS_NODE, TIMES_NODE, DIVIDE_NODE, AND_NODE, OR_NODE,
+	EQUALS_NODE, NOT_EQUALS_NODE, LESS_NODE, GREATER_NODE,
+	LESS_EQ_NODE, GREATER_EQ_NODE,
+	ASSIGN_STMT_NODE, POST_INC_STMT_NODE, POST_DEC_STMT_NODE,
+	READ_STMT_NODE, WRITE_STMT_NODE, IF_STMT_NODE, IF_ELSE_STMT_NODE,
+	WHILE_STMT_NODE, CALL_STMT_NODE, RETURN_STMT_NODE,
+	NUM_NODE_KINDS
+};
+
+class ASTNode : public MemCounted<AST_ALLOC>{
+public:
+	//Nodes built from a token's line and column are given a
+	// location by the SourceManager installed on this thread
+	ASTNode(NodeKind kindIn, size_t lineIn, size_t colIn);
+	ASTNode(NodeKind kindIn, SourceLoc locIn)
+	: loc(locIn), id(nextID()), kind(kindIn){ }
+	NodeKind getKind(){ return static_cast<NodeKind>(kind); }
+	//Print the tree rooted here back out as Lake source
+	void unparse(std::ostream& out, int indent);
 	virtual bool nameAnalysis(SymbolTable *) = 0;
 	//Note that there is no ASTNode::typeAnalysis. To allow
 	// for different function signatures, you may want to 
 	// implement type analysis per-subclass without overrides
 	void doIndent(std::ostream&, int);
-	virtual size_t getLine();
-	virtual size_t getCol();
-	virtual std::string getPosition();
+	SourceLoc getLoc(){ return loc; }
+	//Give the node a location that is already encoded, e.g. when
+	// rebuilding a tree from a FlatAST
+	void setLoc(SourceLoc locIn){ loc = locIn; }
+	size_t getLine();
+	size_t getCol();
+	std::string getPosition();
+	//Nodes are numbered densely from 0, in the order the calling
+	// thread builds them, so that per-node results of a pass can
+	// be kept in vectors indexed by ID (see TypeAnalysis)
+	uint32_t getID() const { return id; }
+	//Number the next node this thread builds 0. Side tables must
+	// not be used with the nodes built before.
+	static void restartIDs();
+	//One more than the highest ID given out since the restart
+	static size_t idBound();
+	//The number of nodes built so far by the calling thread
+	static size_t constructed();
 private:
-	size_t line;
-	size_t col;
+	static uint32_t nextID();
+	SourceLoc loc;
+	uint32_t id;
+	//Stored in a byte, so that subclass fields can fill the rest
+	// of the word
+	uint8_t kind;
 };
 
 class ProgramNode : public ASTNode{
 public:
 	ProgramNode(DeclListNode *);
-	void unparse(std::ostream&, int) override;
 	virtual bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis * ta);
 	virtual ~ProgramNode(){ }
+	DeclListNode * getDeclList(){ return myDeclList; }
 private:
 	DeclListNode * myDeclList;
 };
 
 class TypeNode : public ASTNode{
 public:
-	TypeNode(size_t lineIn, size_t colIn);
-	void unparse(std::ostream&, int) override = 0;
+	TypeNode(NodeKind kindIn, size_t lineIn, size_t colIn);
 	virtual const DataType * getDataType() = 0;
 	virtual std::string getTypeString();
 	virtual bool nameAnalysis(SymbolTable *) override;
@@ -76,42 +121,50 @@ private:
 
 class DeclListNode : public ASTNode{
 public:
-	DeclListNode(std::list<DeclNode *> * decls) 
-	: ASTNode(0,0){
+	DeclListNode(Seq<DeclNode *> decls) 
+	: ASTNode(DECL_LIST_NODE, NO_LOC){
         	myDecls = decls;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta);
+	Seq<DeclNode *> getDecls(){ return myDecls; }
 private:
-	std::list<DeclNode *> * myDecls;
+	Seq<DeclNode *> myDecls;
 };
 
 class VarDeclListNode : public ASTNode{
 public: 
-	VarDeclListNode(std::list<VarDeclNode *> * decls) 
-	: ASTNode(0, 0), myDecls(decls){ }
-	virtual void unparse(std::ostream&, int);
+	VarDeclListNode(Seq<VarDeclNode *> decls) 
+	: ASTNode(VAR_DECL_LIST_NODE, NO_LOC), myDecls(decls){ }
 	virtual bool nameAnalysis(SymbolTable *);
 	virtual void typeAnalysis(TypeAnalysis * ta);
+	Seq<VarDeclNode *> getDecls(){ return myDecls; }
 private:
-	std::list<VarDeclNode *> * myDecls;
+	Seq<VarDeclNode *> myDecls;
 };
 
 class ExpNode : public ASTNode{
 public:
-	ExpNode(size_t lIn, size_t cIn) : ASTNode(lIn, cIn){ }
-	virtual void unparse(std::ostream& out, int indent) override = 0;
+	ExpNode(NodeKind kindIn, size_t lIn, size_t cIn) 
+	: ASTNode(kindIn, lIn, cIn){ }
+	ExpNode(NodeKind kindIn, SourceLoc locIn) : ASTNode(kindIn, locIn){ }
 	virtual bool nameAnalysis(SymbolTable * symTab) override = 0;
 	virtual void typeAnalysis(TypeAnalysis * ta);
+	//The steps of a hash of an expression's structure: its kind,
+	// the names and literal values in it and the hashes of its
+	// children, but not where it is. Expressions written alike
+	// hash alike, in every run. ExpBuilder hashes expressions this
+	// way as it builds them.
+	static uint32_t mixHash(uint32_t hash, uint32_t value);
+	static uint32_t textHash(const char * text, size_t length);
 };
 
 class DerefNode : public ExpNode {
 public:
 	DerefNode(size_t line, size_t column, ExpNode *);
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis * ta);
+	ExpNode * getTgt(){ return myTgt; }
 private:
 	ExpNode * myTgt;
 };
@@ -119,14 +172,14 @@ private:
 class IdNode : public ExpNode{
 public:
 	IdNode(IDToken * token);
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
-	virtual std::string getString();
+	const std::string& getString();
+	NameID getNameID(){ return myName; }
 	void attachSymbol(SemSymbol * symbolIn);
 	SemSymbol * getSymbol();
 	virtual void typeAnalysis(TypeAnalysis * ta);
 private:
-	std::string myStrVal;
+	NameID myName;
 	SemSymbol * mySymbol;
 };
 
@@ -134,17 +187,19 @@ private:
 
 class StmtNode : public ASTNode{
 public:
-	StmtNode(size_t lIn, size_t cIn) : ASTNode(lIn, cIn){ }
-	virtual void unparse(std::ostream& out, int indent) override = 0;
+	StmtNode(NodeKind kindIn, size_t lIn, size_t cIn) 
+	: ASTNode(kindIn, lIn, cIn){ }
+	StmtNode(NodeKind kindIn, SourceLoc locIn) : ASTNode(kindIn, locIn){ }
 	virtual void typeAnalysis(TypeAnalysis * ta, FnType * fnType);
 };
 
 class DeclNode : public ASTNode{
 public:
-	DeclNode(size_t l, size_t c, IdNode *); 
-	void unparse(std::ostream& out, int indent) override =0;
+	DeclNode(NodeKind kindIn, SourceLoc locIn, IdNode * idIn)
+	: ASTNode(kindIn, locIn), myID(idIn){ }
 	virtual const DataType * getDeclaredType() const = 0;
-	std::string getDeclaredName();
+	const std::string& getDeclaredName();
+	NameID getDeclaredNameID(){ return myID->getNameID(); }
 	IdNode * getDeclaredID();
 	virtual void typeAnalysis(TypeAnalysis * ta);
 protected:
@@ -154,8 +209,7 @@ protected:
 class FormalDeclNode : public DeclNode{
 public:
 	FormalDeclNode(TypeNode * type, IdNode * id) 
-	: DeclNode(id->getLine(), id->getCol(), id), myType(type){ }
-	void unparse(std::ostream& out, int indent) override;
+	: DeclNode(FORMAL_DECL_NODE, id->getLoc(), id), myType(type){ }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual TypeNode * getTypeNode() { return myType; }
 	virtual const DataType * getDeclaredType() const { 
@@ -167,63 +221,62 @@ private:
 
 class FormalsListNode : public ASTNode{
 public:
-	FormalsListNode(std::list<FormalDeclNode *>* formalsIn)
-	: ASTNode(0, 0){
+	FormalsListNode(Seq<FormalDeclNode *> formalsIn)
+	: ASTNode(FORMALS_LIST_NODE, NO_LOC){
 		myFormals = formalsIn;
-		auto eltTypeList = new std::list<const DataType *>();
-		for (auto elt : *formalsIn){
-			eltTypeList->push_back(elt->getDeclaredType());
+		std::vector<const DataType *> eltTypes;
+		for (auto elt : formalsIn){
+			eltTypes.push_back(elt->getDeclaredType());
 		}
-		myDataType = new TupleType(eltTypeList);
+		myDataType = TupleType::produce(eltTypes);
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
-	std::list<FormalDeclNode *> * getDecls(){ return myFormals; }
+	Seq<FormalDeclNode *> getDecls(){ return myFormals; }
 	TupleType * getDeclaredType(){ return myDataType; }
 	virtual void typeAnalysis(TypeAnalysis * ta);
 private:
-	std::list<FormalDeclNode *> * myFormals;
+	Seq<FormalDeclNode *> myFormals;
 	TupleType * myDataType;
 };
 
 class ExpListNode : public ASTNode{
 public:
-	ExpListNode(std::list<ExpNode *> * exps) 
-	: ASTNode(0,0){
+	ExpListNode(Seq<ExpNode *> exps) 
+	: ASTNode(EXP_LIST_NODE, NO_LOC){
 		myExps = exps;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis * ta);
-	size_t size(){ return myExps->size(); }
-	std::list<ExpNode *> * getExps() { return myExps; }
+	size_t size(){ return myExps.size(); }
+	Seq<ExpNode *> getExps() { return myExps; }
 private:
-	std::list<ExpNode *> * myExps;
+	Seq<ExpNode *> myExps;
 };
 
 class StmtListNode : public ASTNode{
 public:
-	StmtListNode(std::list<StmtNode *> * stmtsIn) 
-	: ASTNode(0,0){
+	StmtListNode(Seq<StmtNode *> stmtsIn) 
+	: ASTNode(STMT_LIST_NODE, NO_LOC){
 		myStmts = stmtsIn;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, FnType * fnType);
+	Seq<StmtNode *> getStmts(){ return myStmts; }
 private:
-	std::list<StmtNode *> * myStmts;
+	Seq<StmtNode *> myStmts;
 };
 
 class FnBodyNode : public ASTNode{
 public:
 	FnBodyNode(size_t lIn, size_t cIn, VarDeclListNode * decls, StmtListNode * stmts) 
-	: ASTNode(lIn, cIn){
+	: ASTNode(FN_BODY_NODE, lIn, cIn){
 		myStmtList = stmts;
 		myVarDecls = decls;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, FnType * fnDeclType);
+	VarDeclListNode * getVarDecls(){ return myVarDecls; }
+	StmtListNode * getStmtList(){ return myStmtList; }
 private:
 	StmtListNode * myStmtList;
 	VarDeclListNode * myVarDecls;
@@ -237,12 +290,12 @@ public:
 		IdNode * id, 
 		FormalsListNode * formals, 
 		FnBodyNode * fnBody) 
-		: DeclNode(retASTNode->getLine(),retASTNode->getCol(), id)
+		: DeclNode(FN_DECL_NODE, retASTNode->getLoc(), id)
 	{
 		myFormals = formals;
 		myBody = fnBody;
 		myRetAST = retASTNode;
-		myType = new FnType(
+		myType = FnType::produce(
 			formals->getDeclaredType(),
 			myRetAST->getDataType());
 	}
@@ -250,9 +303,10 @@ public:
 	virtual const DataType * getDeclaredType() const override {
 		return myType;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta);
+	FormalsListNode * getFormals(){ return myFormals; }
+	FnBodyNode * getBody(){ return myBody; }
 private:
 	FormalsListNode * myFormals;
 	FnBodyNode * myBody;
@@ -266,8 +320,7 @@ private:
 class IntNode : public TypeNode{
 public:
 	IntNode(size_t lIn, size_t cIn) 
-	: TypeNode(lIn, cIn){}
-	void unparse(std::ostream& out, int indent) override;
+	: TypeNode(INT_NODE, lIn, cIn){}
 	virtual const DataType * getDataType() override;
 	virtual void typeAnalysis(TypeAnalysis * ta);
 };
@@ -275,8 +328,7 @@ public:
 class BoolNode : public TypeNode{
 public:
 	BoolNode(size_t lIn, size_t cIn) 
-	: TypeNode(lIn, cIn) { }
-	void unparse(std::ostream& out, int indent) override;
+	: TypeNode(BOOL_NODE, lIn, cIn) { }
 	virtual const DataType * getDataType() override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
@@ -284,19 +336,17 @@ public:
 class VoidNode : public TypeNode{
 public:
 	VoidNode(size_t lIn, size_t cIn) 
-	: TypeNode(lIn, cIn){}
+	: TypeNode(VOID_NODE, lIn, cIn){}
 	virtual const DataType * getDataType() override;
-	void unparse(std::ostream& out, int indent) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
 class IntLitNode : public ExpNode{
 public:
 	IntLitNode(IntLitToken * token)
-	: ExpNode(token->_line, token->_column){
+	: ExpNode(INT_LIT_NODE, token->_line, token->_column){
 		myInt = token->value();
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override { 
 		if (symTab == nullptr) { 
 			throw InternalError("null symtab");
@@ -304,30 +354,34 @@ public:
 		return true; 
 	}
 	void typeAnalysis(TypeAnalysis * ta) override;
+	int getValue(){ return myInt; }
 private:
 	int myInt;
 };
 
 class StrLitNode : public ExpNode{
 public:
-	StrLitNode(StringLitToken * token)
-	: ExpNode(token->_line, token->_column){
-		myString = token->value();
-	}
-	void unparse(std::ostream& out, int indent) override;
+	//The literal's text is copied into the arena, since tokens
+	// do not outlive the parse
+	StrLitNode(StringLitToken * token, Arena& arena)
+	: ExpNode(STR_LIT_NODE, token->_line, token->_column),
+	  myText(arena.copyString(token->text(), token->length())),
+	  myLength(token->length()){ }
 	bool nameAnalysis(SymbolTable *) override { 
 		return true; 
 	}
 	void typeAnalysis(TypeAnalysis * ta);
+	const char * getText(){ return myText; }
+	size_t getLength(){ return myLength; }
 private:
-	 std::string myString;
+	const char * myText;
+	size_t myLength;
 };
 
 
 class TrueNode : public ExpNode{
 public:
-	TrueNode(size_t lIn, size_t cIn): ExpNode(lIn, cIn){ }
-	void unparse(std::ostream& out, int indent) override;
+	TrueNode(size_t lIn, size_t cIn): ExpNode(TRUE_NODE, lIn, cIn){ }
 	bool nameAnalysis(SymbolTable *) override { 
 		return true; 
 	}
@@ -336,8 +390,7 @@ public:
 
 class FalseNode : public ExpNode{
 public:
-	FalseNode(size_t lIn, size_t cIn): ExpNode(lIn, cIn){ }
-	void unparse(std::ostream& out, int indent) override;
+	FalseNode(size_t lIn, size_t cIn): ExpNode(FALSE_NODE, lIn, cIn){ }
 	bool nameAnalysis(SymbolTable * symTab) override { 
 		if (symTab == nullptr) { 
 			throw InternalError("null symTab"); 
@@ -350,13 +403,14 @@ public:
 class AssignNode : public ExpNode{
 public:
 	AssignNode(size_t lIn, size_t cIn, ExpNode * tgt, ExpNode * src)
-	: ExpNode(lIn, cIn){
+	: ExpNode(ASSIGN_NODE, lIn, cIn){
 		myTgt = tgt;
 		mySrc = src;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta);
+	ExpNode * getTgt(){ return myTgt; }
+	ExpNode * getSrc(){ return mySrc; }
 private:
 	ExpNode * myTgt;
 	ExpNode * mySrc;
@@ -365,13 +419,14 @@ private:
 class CallExpNode : public ExpNode{
 public:
 	CallExpNode(IdNode * id, ExpListNode * expList)
-	: ExpNode(id->getLine(), id->getCol()){
+	: ExpNode(CALL_EXP_NODE, id->getLoc()){
 		myId = id;
 		myExpList = expList;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis * ta);
+	IdNode * getId(){ return myId; }
+	ExpListNode * getExpList(){ return myExpList; }
 private:
 	IdNode * myId;
 	ExpListNode * myExpList;
@@ -379,12 +434,16 @@ private:
 
 class UnaryExpNode : public ExpNode {
 public:
-	UnaryExpNode(size_t lIn, size_t cIn, ExpNode * expIn) 
-	: ExpNode(lIn, cIn){
+	UnaryExpNode(NodeKind kindIn, size_t lIn, size_t cIn, ExpNode * expIn) 
+	: ExpNode(kindIn, lIn, cIn){
+		this->myExp = expIn;
+	}
+	UnaryExpNode(NodeKind kindIn, SourceLoc locIn, ExpNode * expIn) 
+	: ExpNode(kindIn, locIn){
 		this->myExp = expIn;
 	}
-	virtual void unparse(std::ostream& out, int indent) override = 0;
 	virtual bool nameAnalysis(SymbolTable * symTab) override = 0;
+	ExpNode * getExp(){ return myExp; }
 protected:
 	ExpNode * myExp;
 };
@@ -392,33 +451,30 @@ protected:
 class UnaryMinusNode : public UnaryExpNode{
 public:
 	UnaryMinusNode(ExpNode * exp)
-	: UnaryExpNode(exp->getLine(), exp->getCol(), exp){ }
-	void unparse(std::ostream& out, int indent) override;
+	: UnaryExpNode(UNARY_MINUS_NODE, exp->getLoc(), exp){ }
 	bool nameAnalysis(SymbolTable * symTab) override;
 };
 
 class NotNode : public UnaryExpNode{
 public:
 	NotNode(size_t lIn, size_t cIn, ExpNode * exp)
-	: UnaryExpNode(lIn, cIn, exp){ }
-	void unparse(std::ostream& out, int indent) override;
+	: UnaryExpNode(NOT_NODE, lIn, cIn, exp){ }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis * ta);
 };
 
 class BinaryExpNode : public ExpNode{
 public:
-	BinaryExpNode(
+	BinaryExpNode(NodeKind kindIn, 
 		size_t lIn, size_t cIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: ExpNode(lIn, cIn) {
+	: ExpNode(kindIn, lIn, cIn) {
 		this->myExp1 = exp1;
 		this->myExp2 = exp2;
 	}
-	virtual void unparse(std::ostream& out, int indent)
-		override;
-	virtual std::string myOp() = 0;
 	bool nameAnalysis(SymbolTable * symTab) override;
+	ExpNode * getExp1(){ return myExp1; }
+	ExpNode * getExp2(){ return myExp2; }
 protected:
 	ExpNode * myExp1;
 	ExpNode * myExp2;
@@ -428,8 +484,7 @@ class PlusNode : public BinaryExpNode{
 public:
 	PlusNode(size_t lIn, size_t cIn, 
 		ExpNode * exp1, ExpNode * exp2) 
-	: BinaryExpNode(lIn, cIn, exp1, exp2) { }
-	virtual std::string myOp() override { return "+"; }
+	: BinaryExpNode(PLUS_NODE, lIn, cIn, exp1, exp2) { }
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -437,8 +492,7 @@ class MinusNode : public BinaryExpNode{
 public:
 	MinusNode(size_t lIn, size_t cIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lIn, cIn, exp1, exp2){ }
-	virtual std::string myOp() override { return "-"; }
+	: BinaryExpNode(MINUS_NODE, lIn, cIn, exp1, exp2){ }
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -446,8 +500,7 @@ class TimesNode : public BinaryExpNode{
 public:
 	TimesNode(size_t lIn, size_t cIn,
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lIn, cIn, exp1, exp2){ }
-	virtual std::string myOp() override { return "*"; }
+	: BinaryExpNode(TIMES_NODE, lIn, cIn, exp1, exp2){ }
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -455,8 +508,7 @@ class DivideNode : public BinaryExpNode{
 public:
 	DivideNode(size_t lIn, size_t cIn,
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lIn, cIn, exp1, exp2){ }
-	virtual std::string myOp() override { return "/"; }
+	: BinaryExpNode(DIVIDE_NODE, lIn, cIn, exp1, exp2){ }
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -464,8 +516,7 @@ class AndNode : public BinaryExpNode{
 public:
 	AndNode(size_t lIn, size_t cIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lIn, cIn, exp1, exp2){ }
-	virtual std::string myOp() override { return " and "; }
+	: BinaryExpNode(AND_NODE, lIn, cIn, exp1, exp2){ }
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -473,8 +524,7 @@ class OrNode : public BinaryExpNode{
 public:
 	OrNode(size_t lIn, size_t cIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lIn, cIn, exp1, exp2){ }
-	virtual std::string myOp() override { return " or "; }
+	: BinaryExpNode(OR_NODE, lIn, cIn, exp1, exp2){ }
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -482,8 +532,7 @@ class EqualsNode : public BinaryExpNode{
 public:
 	EqualsNode(size_t lineIn, size_t colIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
-	virtual std::string myOp() override { return "=="; }
+	: BinaryExpNode(EQUALS_NODE, lineIn, colIn, exp1, exp2){ }
 	void typeAnalysis(TypeAnalysis * ta) override; 
 };
 
@@ -491,8 +540,7 @@ class NotEqualsNode : public BinaryExpNode{
 public:
 	NotEqualsNode(size_t lineIn, size_t colIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
-	virtual std::string myOp() override { return "!="; } 
+	: BinaryExpNode(NOT_EQUALS_NODE, lineIn, colIn, exp1, exp2){ }
 	void typeAnalysis(TypeAnalysis * ta) override;
 	
 };
@@ -501,8 +549,7 @@ class LessNode : public BinaryExpNode{
 public:
 	LessNode(size_t lineIn, size_t colIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
-	virtual std::string myOp() override { return "<"; }
+	: BinaryExpNode(LESS_NODE, lineIn, colIn, exp1, exp2){ }
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -510,8 +557,7 @@ class GreaterNode : public BinaryExpNode{
 public:
 	GreaterNode(size_t lineIn, size_t colIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
-	virtual std::string myOp() override { return ">"; }
+	: BinaryExpNode(GREATER_NODE, lineIn, colIn, exp1, exp2){ }
 	void typeAnalysis(TypeAnalysis * ta) override; 
 };
 
@@ -519,8 +565,7 @@ class LessEqNode : public BinaryExpNode{
 public:
 	LessEqNode(size_t lineIn, size_t colIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
-	virtual std::string myOp() override { return "<="; } 
+	: BinaryExpNode(LESS_EQ_NODE, lineIn, colIn, exp1, exp2){ }
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -528,20 +573,19 @@ class GreaterEqNode : public BinaryExpNode{
 public:
 	GreaterEqNode(size_t lineIn, size_t colIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
-	virtual std::string myOp() override { return ">="; } 
+	: BinaryExpNode(GREATER_EQ_NODE, lineIn, colIn, exp1, exp2){ }
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
 class AssignStmtNode : public StmtNode{
 public:
 	AssignStmtNode(AssignNode * assignment)
-	: StmtNode(assignment->getLine(), assignment->getCol()){
+	: StmtNode(ASSIGN_STMT_NODE, assignment->getLoc()){
 		myAssign = assignment;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis * ta, FnType * fnType) override;
+	AssignNode * getAssign(){ return myAssign; }
 private:
 	AssignNode * myAssign;
 };
@@ -549,15 +593,15 @@ private:
 class PostIncStmtNode : public StmtNode{
 public:
 	PostIncStmtNode(ExpNode * exp)
-	: StmtNode(exp->getLine(), exp->getCol()){
-		if (exp->getLine() == 0){
+	: StmtNode(POST_INC_STMT_NODE, exp->getLoc()){
+		if (exp->getLoc() == NO_LOC){
 			throw InternalError("0 pos");
 		}	
 		myExp = exp;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, FnType * fnType) override;
+	ExpNode * getExp(){ return myExp; }
 private:
 	ExpNode * myExp;
 };
@@ -565,12 +609,12 @@ private:
 class PostDecStmtNode : public StmtNode{
 public:
 	PostDecStmtNode(ExpNode * exp)
-	: StmtNode(exp->getLine(), exp->getCol()){
+	: StmtNode(POST_DEC_STMT_NODE, exp->getLoc()){
 		myExp = exp;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, FnType * fnType) override;
+	ExpNode * getExp(){ return myExp; }
 private:
 	ExpNode * myExp;
 };
@@ -578,12 +622,12 @@ private:
 class ReadStmtNode : public StmtNode{
 public:
 	ReadStmtNode(ExpNode * exp)
-	: StmtNode(exp->getLine(), exp->getCol()){
+	: StmtNode(READ_STMT_NODE, exp->getLoc()){
 		myExp = exp;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis * ta, FnType * fnType) override;
+	ExpNode * getExp(){ return myExp; }
 private:
 	ExpNode * myExp;
 };
@@ -591,12 +635,12 @@ private:
 class WriteStmtNode : public StmtNode{
 public:
 	WriteStmtNode(ExpNode * exp)
-	: StmtNode(exp->getLine(), exp->getCol()){
+	: StmtNode(WRITE_STMT_NODE, exp->getLoc()){
 		myExp = exp;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis * ta, FnType * fnType) override;
+	ExpNode * getExp(){ return myExp; }
 private:
 	ExpNode * myExp;
 };
@@ -604,14 +648,16 @@ private:
 class IfStmtNode : public StmtNode{
 public:
 	IfStmtNode(size_t lineIn, size_t colIn, ExpNode * exp, VarDeclListNode * decls, StmtListNode * stmts)
-	: StmtNode(lineIn, colIn){
+	: StmtNode(IF_STMT_NODE, lineIn, colIn){
 		myExp = exp;
 		myStmts = stmts;
 		myDecls = decls;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, FnType * fnType);
+	ExpNode * getExp(){ return myExp; }
+	VarDeclListNode * getDecls(){ return myDecls; }
+	StmtListNode * getStmts(){ return myStmts; }
 private:
 	ExpNode * myExp;
 	VarDeclListNode * myDecls;
@@ -621,16 +667,20 @@ private:
 class IfElseStmtNode : public StmtNode{
 public:
 	IfElseStmtNode(ExpNode * exp, VarDeclListNode * declsT, StmtListNode * stmtsT, VarDeclListNode * declsF, StmtListNode * stmtsF)
-	: StmtNode(exp->getLine(), exp->getCol()){
+	: StmtNode(IF_ELSE_STMT_NODE, exp->getLoc()){
 		myExp = exp;
 		myDeclsT = declsT;
 		myStmtsT = stmtsT;
 		myDeclsF = declsF;
 		myStmtsF = stmtsF;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, FnType * fnType);
+	ExpNode * getExp(){ return myExp; }
+	VarDeclListNode * getDeclsT(){ return myDeclsT; }
+	StmtListNode * getStmtsT(){ return myStmtsT; }
+	VarDeclListNode * getDeclsF(){ return myDeclsF; }
+	StmtListNode * getStmtsF(){ return myStmtsF; }
 private:
 	ExpNode * myExp;
 	VarDeclListNode * myDeclsT;
@@ -642,14 +692,16 @@ private:
 class WhileStmtNode : public StmtNode{
 public:
 	WhileStmtNode(size_t lineIn, size_t colIn, ExpNode * exp, VarDeclListNode * decls, StmtListNode * stmts)
-	: StmtNode(lineIn, colIn){
+	: StmtNode(WHILE_STMT_NODE, lineIn, colIn){
 		myExp = exp;
 		myDecls = decls;
 		myStmts = stmts;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, FnType * fnType);
+	ExpNode * getExp(){ return myExp; }
+	VarDeclListNode * getDecls(){ return myDecls; }
+	StmtListNode * getStmts(){ return myStmts; }
 private:
 	ExpNode * myExp;
 	VarDeclListNode * myDecls;
@@ -659,12 +711,12 @@ private:
 class CallStmtNode : public StmtNode{
 public:
 	CallStmtNode(CallExpNode * callExp)
-	: StmtNode(callExp->getLine(), callExp->getCol()){
+	: StmtNode(CALL_STMT_NODE, callExp->getLoc()){
 		myCallExp = callExp;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, FnType * fnType);
+	CallExpNode * getCallExp(){ return myCallExp; }
 private:
 	CallExpNode * myCallExp;
 };
@@ -672,12 +724,13 @@ private:
 class ReturnStmtNode : public StmtNode{
 public:
 	ReturnStmtNode(size_t lineIn, size_t colIn, ExpNode * exp)
-	: StmtNode(lineIn, colIn){
+	: StmtNode(RETURN_STMT_NODE, lineIn, colIn){
 		myExp = exp;
 	}
-	void unparse(std::ostream& out, int indent) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, FnType * fnType);
+	//Null for a bare return
+	ExpNode * getExp(){ return myExp; }
 private:
 	ExpNode * myExp;
 };
@@ -685,8 +738,7 @@ private:
 class VarDeclNode : public DeclNode{
 public:
 	VarDeclNode(TypeNode * type, IdNode * id) 
-	: DeclNode(id->getLine(), id->getCol(), id), myType(type){ }
-	void unparse(std::ostream& out, int indent) override;
+	: DeclNode(VAR_DECL_NODE, id->getLoc(), id), myType(type){ }
 	virtual const DataType * getDeclaredType() const { 
 		return myType->getDataType(); }
 	bool nameAnalysis(SymbolTable * symTab) override;
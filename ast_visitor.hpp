@@ -0,0 +1,483 @@
+#ifndef LAKE_AST_VISITOR_HPP
+#define LAKE_AST_VISITOR_HPP
+
+#include "ast.hpp"
+
+namespace lake{
+
+//A traversal that dispatches on NodeKind instead of making a
+// virtual call at every node. A pass derives from
+// ASTVisitor<Pass, Result> and declares the visit methods it cares
+// about; visit(node) switches on the node's kind and calls the
+// pass's method directly, so the call can be inlined. A method the
+// pass leaves out falls back to the one for the node's family
+// (visitExpNode, visitStmtNode, ...) and then to visitNode, which
+// visits the node's children in source order.
+template <typename Pass, typename Result = void>
+class ASTVisitor{
+public:
+	Result visit(ASTNode * node){
+		switch(node->getKind()){
+		case PROGRAM_NODE:
+			return pass().visitProgramNode(static_cast<ProgramNode *>(node));
+		case DECL_LIST_NODE:
+			return pass().visitDeclListNode(static_cast<DeclListNode *>(node));
+		case VAR_DECL_LIST_NODE:
+			return pass().visitVarDeclListNode(static_cast<VarDeclListNode *>(node));
+		case FORMALS_LIST_NODE:
+			return pass().visitFormalsListNode(static_cast<FormalsListNode *>(node));
+		case EXP_LIST_NODE:
+			return pass().visitExpListNode(static_cast<ExpListNode *>(node));
+		case STMT_LIST_NODE:
+			return pass().visitStmtListNode(static_cast<StmtListNode *>(node));
+		case FN_BODY_NODE:
+			return pass().visitFnBodyNode(static_cast<FnBodyNode *>(node));
+		case VAR_DECL_NODE:
+			return pass().visitVarDeclNode(static_cast<VarDeclNode *>(node));
+		case FORMAL_DECL_NODE:
+			return pass().visitFormalDeclNode(static_cast<FormalDeclNode *>(node));
+		case FN_DECL_NODE:
+			return pass().visitFnDeclNode(static_cast<FnDeclNode *>(node));
+		case INT_NODE:
+			return pass().visitIntNode(static_cast<IntNode *>(node));
+		case BOOL_NODE:
+			return pass().visitBoolNode(static_cast<BoolNode *>(node));
+		case VOID_NODE:
+			return pass().visitVoidNode(static_cast<VoidNode *>(node));
+		case DEREF_NODE:
+			return pass().visitDerefNode(static_cast<DerefNode *>(node));
+		case ID_NODE:
+			return pass().visitIdNode(static_cast<IdNode *>(node));
+		case INT_LIT_NODE:
+			return pass().visitIntLitNode(static_cast<IntLitNode *>(node));
+		case STR_LIT_NODE:
+			return pass().visitStrLitNode(static_cast<StrLitNode *>(node));
+		case TRUE_NODE:
+			return pass().visitTrueNode(static_cast<TrueNode *>(node));
+		case FALSE_NODE:
+			return pass().visitFalseNode(static_cast<FalseNode *>(node));
+		case ASSIGN_NODE:
+			return pass().visitAssignNode(static_cast<AssignNode *>(node));
+		case CALL_EXP_NODE:
+			return pass().visitCallExpNode(static_cast<CallExpNode *>(node));
+		case UNARY_MINUS_NODE:
+			return pass().visitUnaryMinusNode(static_cast<UnaryMinusNode *>(node));
+		case NOT_NODE:
+			return pass().visitNotNode(static_cast<NotNode *>(node));
+		case PLUS_NODE:
+			return pass().visitPlusNode(static_cast<PlusNode *>(node));
+		case MINUS_NODE:
+			return pass().visitMinusNode(static_cast<MinusNode *>(node));
+		case TIMES_NODE:
+			return pass().visitTimesNode(static_cast<TimesNode *>(node));
+		case DIVIDE_NODE:
+			return pass().visitDivideNode(static_cast<DivideNode *>(node));
+		case AND_NODE:
+			return pass().visitAndNode(static_cast<AndNode *>(node));
+		case OR_NODE:
+			return pass().visitOrNode(static_cast<OrNode *>(node));
+		case EQUALS_NODE:
+			return pass().visitEqualsNode(static_cast<EqualsNode *>(node));
+		case NOT_EQUALS_NODE:
+			return pass().visitNotEqualsNode(static_cast<NotEqualsNode *>(node));
+		case LESS_NODE:
+			return pass().visitLessNode(static_cast<LessNode *>(node));
+		case GREATER_NODE:
+			return pass().visitGreaterNode(static_cast<GreaterNode *>(node));
+		case LESS_EQ_NODE:
+			return pass().visitLessEqNode(static_cast<LessEqNode *>(node));
+		case GREATER_EQ_NODE:
+			return pass().visitGreaterEqNode(static_cast<GreaterEqNode *>(node));
+		case ASSIGN_STMT_NODE:
+			return pass().visitAssignStmtNode(static_cast<AssignStmtNode *>(node));
+		case POST_INC_STMT_NODE:
+			return pass().visitPostIncStmtNode(static_cast<PostIncStmtNode *>(node));
+		case POST_DEC_STMT_NODE:
+			return pass().visitPostDecStmtNode(static_cast<PostDecStmtNode *>(node));
+		case READ_STMT_NODE:
+			return pass().visitReadStmtNode(static_cast<ReadStmtNode *>(node));
+		case WRITE_STMT_NODE:
+			return pass().visitWriteStmtNode(static_cast<WriteStmtNode *>(node));
+		case IF_STMT_NODE:
+			return pass().visitIfStmtNode(static_cast<IfStmtNode *>(node));
+		case IF_ELSE_STMT_NODE:
+			return pass().visitIfElseStmtNode(static_cast<IfElseStmtNode *>(node));
+		case WHILE_STMT_NODE:
+			return pass().visitWhileStmtNode(static_cast<WhileStmtNode *>(node));
+		case CALL_STMT_NODE:
+			return pass().visitCallStmtNode(static_cast<CallStmtNode *>(node));
+		case RETURN_STMT_NODE:
+			return pass().visitReturnStmtNode(static_cast<ReturnStmtNode *>(node));
+		case NUM_NODE_KINDS:
+			break;
+		}
+		throw new InternalError("Visiting a node of unknown kind");
+	}
+
+	//Visit each child of node in source order
+	void visitChildren(ASTNode * node){
+		switch(node->getKind()){
+		case PROGRAM_NODE:
+			{
+			ProgramNode * n = static_cast<ProgramNode *>(node);
+			pass().visit(n->getDeclList());
+			return;
+			}
+		case DECL_LIST_NODE:
+			{
+			DeclListNode * n = static_cast<DeclListNode *>(node);
+			for (auto child : n->getDecls()){ pass().visit(child); }
+			return;
+			}
+		case VAR_DECL_LIST_NODE:
+			{
+			VarDeclListNode * n = static_cast<VarDeclListNode *>(node);
+			for (auto child : n->getDecls()){ pass().visit(child); }
+			return;
+			}
+		case FORMALS_LIST_NODE:
+			{
+			FormalsListNode * n = static_cast<FormalsListNode *>(node);
+			for (auto child : n->getDecls()){ pass().visit(child); }
+			return;
+			}
+		case EXP_LIST_NODE:
+			{
+			ExpListNode * n = static_cast<ExpListNode *>(node);
+			for (auto child : n->getExps()){ pass().visit(child); }
+			return;
+			}
+		case STMT_LIST_NODE:
+			{
+			StmtListNode * n = static_cast<StmtListNode *>(node);
+			for (auto child : n->getStmts()){ pass().visit(child); }
+			return;
+			}
+		case FN_BODY_NODE:
+			{
+			FnBodyNode * n = static_cast<FnBodyNode *>(node);
+			pass().visit(n->getVarDecls());
+			pass().visit(n->getStmtList());
+			return;
+			}
+		case VAR_DECL_NODE:
+			{
+			VarDeclNode * n = static_cast<VarDeclNode *>(node);
+			pass().visit(n->getTypeNode());
+			pass().visit(n->getDeclaredID());
+			return;
+			}
+		case FORMAL_DECL_NODE:
+			{
+			FormalDeclNode * n = static_cast<FormalDeclNode *>(node);
+			pass().visit(n->getTypeNode());
+			pass().visit(n->getDeclaredID());
+			return;
+			}
+		case FN_DECL_NODE:
+			{
+			FnDeclNode * n = static_cast<FnDeclNode *>(node);
+			pass().visit(n->getReturnTypeNode());
+			pass().visit(n->getDeclaredID());
+			pass().visit(n->getFormals());
+			pass().visit(n->getBody());
+			return;
+			}
+		case DEREF_NODE:
+			{
+			DerefNode * n = static_cast<DerefNode *>(node);
+			pass().visit(n->getTgt());
+			return;
+			}
+		case ASSIGN_NODE:
+			{
+			AssignNode * n = static_cast<AssignNode *>(node);
+			pass().visit(n->getTgt());
+			pass().visit(n->getSrc());
+			return;
+			}
+		case CALL_EXP_NODE:
+			{
+			CallExpNode * n = static_cast<CallExpNode *>(node);
+			pass().visit(n->getId());
+			pass().visit(n->getExpList());
+			return;
+			}
+		case UNARY_MINUS_NODE:
+			{
+			UnaryMinusNode * n = static_cast<UnaryMinusNode *>(node);
+			pass().visit(n->getExp());
+			return;
+			}
+		case NOT_NODE:
+			{
+			NotNode * n = static_cast<NotNode *>(node);
+			pass().visit(n->getExp());
+			return;
+			}
+		case ASSIGN_STMT_NODE:
+			{
+			AssignStmtNode * n = static_cast<AssignStmtNode *>(node);
+			pass().visit(n->getAssign());
+			return;
+			}
+		case POST_INC_STMT_NODE:
+			{
+			PostIncStmtNode * n = static_cast<PostIncStmtNode *>(node);
+			pass().visit(n->getExp());
+			return;
+			}
+		case POST_DEC_STMT_NODE:
+			{
+			PostDecStmtNode * n = static_cast<PostDecStmtNode *>(node);
+			pass().visit(n->getExp());
+			return;
+			}
+		case READ_STMT_NODE:
+			{
+			ReadStmtNode * n = static_cast<ReadStmtNode *>(node);
+			pass().visit(n->getExp());
+			return;
+			}
+		case WRITE_STMT_NODE:
+			{
+			WriteStmtNode * n = static_cast<WriteStmtNode *>(node);
+			pass().visit(n->getExp());
+			return;
+			}
+		case IF_STMT_NODE:
+			{
+			IfStmtNode * n = static_cast<IfStmtNode *>(node);
+			pass().visit(n->getExp());
+			pass().visit(n->getDecls());
+			pass().visit(n->getStmts());
+			return;
+			}
+		case IF_ELSE_STMT_NODE:
+			{
+			IfElseStmtNode * n = static_cast<IfElseStmtNode *>(node);
+			pass().visit(n->getExp());
+			pass().visit(n->getDeclsT());
+			pass().visit(n->getStmtsT());
+			pass().visit(n->getDeclsF());
+			pass().visit(n->getStmtsF());
+			return;
+			}
+		case WHILE_STMT_NODE:
+			{
+			WhileStmtNode * n = static_cast<WhileStmtNode *>(node);
+			pass().visit(n->getExp());
+			pass().visit(n->getDecls());
+			pass().visit(n->getStmts());
+			return;
+			}
+		case CALL_STMT_NODE:
+			{
+			CallStmtNode * n = static_cast<CallStmtNode *>(node);
+			pass().visit(n->getCallExp());
+			return;
+			}
+		case RETURN_STMT_NODE:
+			{
+			ReturnStmtNode * n = static_cast<ReturnStmtNode *>(node);
+			if (n->getExp() != nullptr){ pass().visit(n->getExp()); }
+			return;
+			}
+		case PLUS_NODE:
+		case MINUS_NODE:
+		case TIMES_NODE:
+		case DIVIDE_NODE:
+		case AND_NODE:
+		case OR_NODE:
+		case EQUALS_NODE:
+		case NOT_EQUALS_NODE:
+		case LESS_NODE:
+		case GREATER_NODE:
+		case LESS_EQ_NODE:
+		case GREATER_EQ_NODE:
+			{
+			BinaryExpNode * n = static_cast<BinaryExpNode *>(node);
+			pass().visit(n->getExp1());
+			pass().visit(n->getExp2());
+			return;
+			}
+		case INT_NODE:
+		case BOOL_NODE:
+		case VOID_NODE:
+		case ID_NODE:
+		case INT_LIT_NODE:
+		case STR_LIT_NODE:
+		case TRUE_NODE:
+		case FALSE_NODE:
+		case NUM_NODE_KINDS:
+			return;
+		}
+	}
+
+	//Per-kind defaults, each deferring to the node's family
+	Result visitProgramNode(ProgramNode * node){
+		return pass().visitNode(node);
+	}
+	Result visitDeclListNode(DeclListNode * node){
+		return pass().visitNode(node);
+	}
+	Result visitVarDeclListNode(VarDeclListNode * node){
+		return pass().visitNode(node);
+	}
+	Result visitFormalsListNode(FormalsListNode * node){
+		return pass().visitNode(node);
+	}
+	Result visitExpListNode(ExpListNode * node){
+		return pass().visitNode(node);
+	}
+	Result visitStmtListNode(StmtListNode * node){
+		return pass().visitNode(node);
+	}
+	Result visitFnBodyNode(FnBodyNode * node){
+		return pass().visitNode(node);
+	}
+	Result visitVarDeclNode(VarDeclNode * node){
+		return pass().visitDeclNode(node);
+	}
+	Result visitFormalDeclNode(FormalDeclNode * node){
+		return pass().visitDeclNode(node);
+	}
+	Result visitFnDeclNode(FnDeclNode * node){
+		return pass().visitDeclNode(node);
+	}
+	Result visitIntNode(IntNode * node){
+		return pass().visitTypeNode(node);
+	}
+	Result visitBoolNode(BoolNode * node){
+		return pass().visitTypeNode(node);
+	}
+	Result visitVoidNode(VoidNode * node){
+		return pass().visitTypeNode(node);
+	}
+	Result visitDerefNode(DerefNode * node){
+		return pass().visitExpNode(node);
+	}
+	Result visitIdNode(IdNode * node){
+		return pass().visitExpNode(node);
+	}
+	Result visitIntLitNode(IntLitNode * node){
+		return pass().visitExpNode(node);
+	}
+	Result visitStrLitNode(StrLitNode * node){
+		return pass().visitExpNode(node);
+	}
+	Result visitTrueNode(TrueNode * node){
+		return pass().visitExpNode(node);
+	}
+	Result visitFalseNode(FalseNode * node){
+		return pass().visitExpNode(node);
+	}
+	Result visitAssignNode(AssignNode * node){
+		return pass().visitExpNode(node);
+	}
+	Result visitCallExpNode(CallExpNode * node){
+		return pass().visitExpNode(node);
+	}
+	Result visitUnaryMinusNode(UnaryMinusNode * node){
+		return pass().visitUnaryExpNode(node);
+	}
+	Result visitNotNode(NotNode * node){
+		return pass().visitUnaryExpNode(node);
+	}
+	Result visitPlusNode(PlusNode * node){
+		return pass().visitBinaryExpNode(node);
+	}
+	Result visitMinusNode(MinusNode * node){
+		return pass().visitBinaryExpNode(node);
+	}
+	Result visitTimesNode(TimesNode * node){
+		return pass().visitBinaryExpNode(node);
+	}
+	Result visitDivideNode(DivideNode * node){
+		return pass().visitBinaryExpNode(node);
+	}
+	Result visitAndNode(AndNode * node){
+		return pass().visitBinaryExpNode(node);
+	}
+	Result visitOrNode(OrNode * node){
+		return pass().visitBinaryExpNode(node);
+	}
+	Result visitEqualsNode(EqualsNode * node){
+		return pass().visitBinaryExpNode(node);
+	}
+	Result visitNotEqualsNode(NotEqualsNode * node){
+		return pass().visitBinaryExpNode(node);
+	}
+	Result visitLessNode(LessNode * node){
+		return pass().visitBinaryExpNode(node);
+	}
+	Result visitGreaterNode(GreaterNode * node){
+		return pass().visitBinaryExpNode(node);
+	}
+	Result visitLessEqNode(LessEqNode * node){
+		return pass().visitBinaryExpNode(node);
+	}
+	Result visitGreaterEqNode(GreaterEqNode * node){
+		return pass().visitBinaryExpNode(node);
+	}
+	Result visitAssignStmtNode(AssignStmtNode * node){
+		return pass().visitStmtNode(node);
+	}
+	Result visitPostIncStmtNode(PostIncStmtNode * node){
+		return pass().visitStmtNode(node);
+	}
+	Result visitPostDecStmtNode(PostDecStmtNode * node){
+		return pass().visitStmtNode(node);
+	}
+	Result visitReadStmtNode(ReadStmtNode * node){
+		return pass().visitStmtNode(node);
+	}
+	Result visitWriteStmtNode(WriteStmtNode * node){
+		return pass().visitStmtNode(node);
+	}
+	Result visitIfStmtNode(IfStmtNode * node){
+		return pass().visitStmtNode(node);
+	}
+	Result visitIfElseStmtNode(IfElseStmtNode * node){
+		return pass().visitStmtNode(node);
+	}
+	Result visitWhileStmtNode(WhileStmtNode * node){
+		return pass().visitStmtNode(node);
+	}
+	Result visitCallStmtNode(CallStmtNode * node){
+		return pass().visitStmtNode(node);
+	}
+	Result visitReturnStmtNode(ReturnStmtNode * node){
+		return pass().visitStmtNode(node);
+	}
+
+	//Family defaults
+	Result visitTypeNode(TypeNode * node){
+		return pass().visitNode(node);
+	}
+	Result visitExpNode(ExpNode * node){
+		return pass().visitNode(node);
+	}
+	Result visitUnaryExpNode(UnaryExpNode * node){
+		return pass().visitExpNode(node);
+	}
+	Result visitBinaryExpNode(BinaryExpNode * node){
+		return pass().visitExpNode(node);
+	}
+	Result visitStmtNode(StmtNode * node){
+		return pass().visitNode(node);
+	}
+	Result visitDeclNode(DeclNode * node){
+		return pass().visitNode(node);
+	}
+	Result visitNode(ASTNode * node){
+		visitChildren(node);
+		return Result();
+	}
+protected:
+	Pass& pass(){ return *static_cast<Pass *>(this); }
+};
+
+} //End namespace lake
+
+#endif
@@ -0,0 +1,91 @@
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include "batch.hpp"
+#include "err.hpp"
+
+namespace lake{
+
+bool readResponseFile(const char * path, std::vector<std::string>& files){
+	std::ifstream in(path);
+	if (!in.good()){ return false; }
+	std::string line;
+	while (std::getline(in, line)){
+		size_t start = line.find_first_not_of(" \t\r");
+		if (start == std::string::npos){ continue; }
+		size_t end = line.find_last_not_of(" \t\r");
+		if (line[start] == '#'){ continue; }
+		files.push_back(line.substr(start, end - start + 1));
+	}
+	return true;
+}
+
+//The outcome of compiling one file of the batch
+class BatchResult{
+public:
+	std::string diagnostics;
+	int status = 0;
+	bool done = false;
+};
+
+int compileBatch(
+	const std::vector<std::string>& files, 
+	const DriverOptions& opts, 
+	size_t workers)
+{
+	if (workers == 0){ workers = 1; }
+	if (workers > files.size()){ workers = files.size(); }
+
+	std::vector<BatchResult> results(files.size());
+	std::atomic<size_t> nextFile(0);
+	std::mutex resultsLock;
+	std::condition_variable resultReady;
+
+	auto worker = [&](){
+		while (true){
+			size_t idx = nextFile++;
+			if (idx >= files.size()){ return; }
+
+			std::ostringstream diags;
+			int status;
+			{
+				Err::Redirect capture(&diags);
+				status = compileFile(files[idx].c_str(), opts);
+			}
+
+			std::lock_guard<std::mutex> guard(resultsLock);
+			results[idx].diagnostics = diags.str();
+			results[idx].status = status;
+			results[idx].done = true;
+			resultReady.notify_all();
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (size_t i = 0 ; i < workers ; i++){
+		pool.emplace_back(worker);
+	}
+
+	//Report each file as soon as it and every file before it
+	// are finished, so output order never depends on scheduling
+	int batchStatus = 0;
+	for (size_t idx = 0 ; idx < files.size() ; idx++){
+		std::unique_lock<std::mutex> lock(resultsLock);
+		resultReady.wait(lock, [&](){ return results[idx].done; });
+		BatchResult& res = results[idx];
+		std::cerr << res.diagnostics;
+		std::cerr << "lakec: " << files[idx] << ": exit " 
+			<< res.status << "\n";
+		if (res.status != 0){ batchStatus = 1; }
+		res.diagnostics.clear();
+	}
+
+	for (std::thread& t : pool){ t.join(); }
+	return batchStatus;
+}
+
+} //End namespace lake
@@ -0,0 +1,25 @@
+#ifndef LAKE_BATCH_HPP
+#define LAKE_BATCH_HPP
+
+#include <string>
+#include <vector>
+#include "driver.hpp"
+
+namespace lake{
+
+//Read a response file: one input path per line. Blank lines
+// and lines starting with '#' are skipped.
+bool readResponseFile(const char * path, std::vector<std::string>& files);
+
+//Compile every file in the list on a pool of worker threads.
+// Each file's diagnostics are captured separately and written to
+// stderr in input order, followed by a line giving that file's
+// exit status. Returns 0 if every file passed, and 1 otherwise.
+int compileBatch(
+	const std::vector<std::string>& files, 
+	const DriverOptions& opts, 
+	size_t workers);
+
+} //End namespace lake
+
+#endif
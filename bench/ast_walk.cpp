@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+#include "bench.hpp"
+#include "../ast_visitor.hpp"
+
+//Compares ways of walking every node of a large tree: the
+// ASTVisitor's switch on NodeKind, and a virtual method called at
+// every node of a copy of the tree. The unparse pass, which is
+// written as virtual methods, is timed for scale.
+//
+// usage: ast_walk [functions] [reps]
+
+using namespace lake;
+
+//Counts nodes with the switch dispatch
+class NodeCounter : public ASTVisitor<NodeCounter>{
+public:
+	NodeCounter() : count(0){ }
+	void visitNode(ASTNode * node){
+		count++;
+		visitChildren(node);
+	}
+	size_t count;
+};
+
+//A node of a copy of the tree that counts its nodes with a
+// virtual call at every node, as a pass written as virtual methods
+// on the nodes would. The copy lives in an arena, like the tree.
+class CountNode{
+public:
+	virtual size_t countNodes() const = 0;
+};
+
+class CountLeaf : public CountNode{
+public:
+	size_t countNodes() const override { return 1; }
+};
+
+class CountInner : public CountNode{
+public:
+	CountInner(CountNode ** childrenIn, size_t sizeIn)
+	: children(childrenIn), size(sizeIn){ }
+	size_t countNodes() const override {
+		size_t count = 1;
+		for (size_t i = 0 ; i < size ; i++){
+			count += children[i]->countNodes();
+		}
+		return count;
+	}
+private:
+	CountNode ** children;
+	size_t size;
+};
+
+//Builds the CountNode copy of a tree, children before parents
+class CountTreeBuilder : public ASTVisitor<CountTreeBuilder>{
+public:
+	CountTreeBuilder(Arena& arenaIn) : arena(arenaIn){ }
+	void visitNode(ASTNode * node){
+		size_t first = built.size();
+		visitChildren(node);
+		size_t size = built.size() - first;
+		if (size == 0){
+			built.push_back(new (arena) CountLeaf());
+			return;
+		}
+		CountNode ** children = static_cast<CountNode **>(
+			arena.allocate(size * sizeof(CountNode *), 
+				alignof(CountNode *)));
+		std::copy(built.begin() + static_cast<std::ptrdiff_t>(first), 
+			built.end(), children);
+		built.resize(first);
+		built.push_back(new (arena) CountInner(children, size));
+	}
+	CountNode * root() const { return built.back(); }
+private:
+	Arena& arena;
+	std::vector<CountNode *> built;
+};
+
+int main(int argc, char * argv[]){
+	size_t functions = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20000;
+	int reps = argc > 2 ? atoi(argv[2]) : 5;
+
+	std::string text = syntheticProgram(functions);
+	SourceManager sources;
+	SourceManager::Scope sourcesScope(&sources);
+	Interner names;
+	Interner::Scope namesScope(&names);
+	Arena arena;
+	ProgramNode * root = parseText(text, arena, sources);
+	if (root == nullptr){
+		fprintf(stderr, "synthetic program did not parse\n");
+		return 1;
+	}
+
+	size_t nodes = 0;
+	double switchMs = bestMillis(reps, [&](){
+		NodeCounter counter;
+		counter.visit(root);
+		nodes = counter.count;
+	});
+	Arena copyArena;
+	CountTreeBuilder builder(copyArena);
+	builder.visit(root);
+	CountNode * copy = builder.root();
+	double virtualMs = bestMillis(reps, [&](){
+		if (copy->countNodes() != nodes){ abort(); }
+	});
+	double unparseMs = bestMillis(reps, [&](){
+		std::ostringstream out;
+		root->unparse(out, 0);
+	});
+
+	printf("%zu functions, %zu nodes, best of %d\n", functions, nodes, reps);
+	report("switch visitor walk", switchMs, nodes, "nodes");
+	report("virtual method walk", virtualMs, nodes, "nodes");
+	report("unparse", unparseMs, nodes, "nodes");
+	return 0;
+}
@@ -0,0 +1,93 @@
+#ifndef LAKE_BENCH_HPP
+#define LAKE_BENCH_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "../scanner.hpp"
+#include "../source_manager.hpp"
+
+namespace lake{
+
+//A Lake program of the given number of functions, each a copy of
+// the same body exercising every kind of statement and most kinds
+// of expression. Each function calls the one before it. The
+// program parses, but is not meant to pass type checking.
+inline std::string syntheticProgram(size_t functions){
+	std::string text;
+	for (size_t i = 0 ; i < functions ; i++){
+		std::string name = "f" + std::to_string(i);
+		std::string callee = "f" + std::to_string(i == 0 ? 0 : i - 1);
+		text += "int " + name + "(int a, bool b, int @ p) {\n"
+		"\tint x;\n"
+		"\tint y;\n"
+		"\tbool c;\n"
+		"\tx = a + 3 * (a - 1) / 2;\n"
+		"\ty = x - a;\n"
+		"\tc = b && x < y || !b;\n"
+		"\tif (c) {\n"
+		"\t\tx = x + 1;\n"
+		"\t}\n"
+		"\telse {\n"
+		"\t\ty = y - 1;\n"
+		"\t}\n"
+		"\twhile (x >= 0) {\n"
+		"\t\tx--;\n"
+		"\t\twrite x;\n"
+		"\t}\n"
+		"\tread y;\n"
+		"\t@p = x;\n"
+		"\t" + callee + "(x, c == b, p);\n"
+		"\treturn x + y;\n"
+		"}\n";
+	}
+	return text;
+}
+
+//Parse source text held in memory. The tree is placed in arena,
+// and its locations come from sources, which must be installed on
+// the calling thread along with an Interner for its names. With
+// shareExps, repeated expressions share nodes (see ExpBuilder).
+// The tree's node IDs start from 0. Returns null on a syntax error.
+inline ProgramNode * parseText(
+	const std::string& text, Arena& arena, SourceManager& sources,
+	bool shareExps = false)
+{
+	SourceFile src;
+	src.useBuffer(text.data(), text.size());
+	Scanner scanner(src, HAND_BACKEND);
+	scanner.noteLocations(&sources);
+	ProgramNode * root = nullptr;
+	ASTNode::restartIDs();
+	ExpBuilder exps(arena, shareExps);
+	Parser parser(scanner, &root, arena, exps);
+	if (parser.parse() != 0){ return nullptr; }
+	return root;
+}
+
+//The fastest of reps runs of body, in milliseconds
+template <typename Body>
+double bestMillis(int reps, Body body){
+	double best = 0;
+	for (int rep = 0 ; rep < reps ; rep++){
+		auto start = std::chrono::steady_clock::now();
+		body();
+		std::chrono::duration<double, std::milli> took =
+			std::chrono::steady_clock::now() - start;
+		if (rep == 0 || took.count() < best){ best = took.count(); }
+	}
+	return best;
+}
+
+//One line of results: the time taken and the rate at which items
+// (nodes, lookups, ...) went by
+inline void report(const char * what, double millis,
+	size_t items, const char * unit)
+{
+	printf("%-28s %10.3f ms %10.1f M%s/s\n", what, millis,
+		static_cast<double>(items) / millis / 1000.0, unit);
+}
+
+} //End namespace lake
+
+#endif
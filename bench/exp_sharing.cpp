@@ -0,0 +1,65 @@
+#include <cstdlib>
+#include "bench.hpp"
+#include "../symbol_table.hpp"
+
+//Compares parsing with and without hash-consed expressions (see
+// ExpBuilder): how long the parse and the later passes take, and
+// how many nodes and arena bytes the tree needs. Diagnostics are
+// discarded.
+//
+// usage: exp_sharing [functions] [reps]
+
+using namespace lake;
+
+static void run(const std::string& text, bool share, int reps){
+	size_t nodes = 0;
+	size_t bytes = 0;
+	double parseMs = bestMillis(reps, [&](){
+		SourceManager sources;
+		SourceManager::Scope sourcesScope(&sources);
+		Interner names;
+		Interner::Scope namesScope(&names);
+		Arena arena;
+		size_t before = ASTNode::constructed();
+		if (parseText(text, arena, sources, share) == nullptr){
+			fprintf(stderr, "synthetic program did not parse\n");
+			exit(1);
+		}
+		nodes = ASTNode::constructed() - before;
+		bytes = arena.bytesUsed();
+	});
+	SourceManager sources;
+	SourceManager::Scope sourcesScope(&sources);
+	Interner names;
+	Interner::Scope namesScope(&names);
+	Arena arena;
+	ProgramNode * root = parseText(text, arena, sources, share);
+	std::ostream discard(nullptr);
+	Err::redirect(&discard);
+	double nameMs = bestMillis(reps, [&](){
+		SymbolTable symTab(arena);
+		root->nameAnalysis(&symTab);
+	});
+	double typeMs = bestMillis(reps, [&](){
+		TypeAnalysis ta;
+		root->typeAnalysis(&ta);
+	});
+	Err::redirect(nullptr);
+
+	printf("%s: %zu nodes, %zu arena bytes\n", 
+		share ? "shared" : "unshared", nodes, bytes);
+	report(share ? "parse, shared" : "parse", parseMs, nodes, "nodes");
+	report("name analysis", nameMs, nodes, "nodes");
+	report("type analysis", typeMs, nodes, "nodes");
+}
+
+int main(int argc, char * argv[]){
+	size_t functions = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20000;
+	int reps = argc > 2 ? atoi(argv[2]) : 5;
+
+	std::string text = syntheticProgram(functions);
+	printf("%zu functions, best of %d\n", functions, reps);
+	run(text, false, reps);
+	run(text, true, reps);
+	return 0;
+}
@@ -0,0 +1,69 @@
+#include <cstdlib>
+#include "bench.hpp"
+#include "../flat_ast.hpp"
+#include "../symbol_table.hpp"
+
+//Compares type checking the pointer tree, through the virtual
+// typeAnalysis methods, with type checking the same tree as a
+// FlatAST in one loop over its arrays. Flattening, and rebuilding
+// a pointer tree from the flat form, are timed on their own.
+// Diagnostics are discarded.
+//
+// usage: flat_types [functions] [reps]
+
+using namespace lake;
+
+int main(int argc, char * argv[]){
+	size_t functions = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20000;
+	int reps = argc > 2 ? atoi(argv[2]) : 5;
+
+	std::string text = syntheticProgram(functions);
+	SourceManager sources;
+	SourceManager::Scope sourcesScope(&sources);
+	Interner names;
+	Interner::Scope namesScope(&names);
+	Arena arena;
+	ProgramNode * root = parseText(text, arena, sources);
+	if (root == nullptr){
+		fprintf(stderr, "synthetic program did not parse\n");
+		return 1;
+	}
+	SymbolTable symTab(arena);
+	if (!root->nameAnalysis(&symTab)){
+		fprintf(stderr, "synthetic program failed name analysis\n");
+		return 1;
+	}
+	std::ostream discard(nullptr);
+	Err::redirect(&discard);
+
+	double treeMs = bestMillis(reps, [&](){
+		TypeAnalysis ta;
+		root->typeAnalysis(&ta);
+	});
+	size_t nodes = 0;
+	double buildMs = bestMillis(reps, [&](){
+		FlatAST flat;
+		flat.build(root);
+		flat.noteSymbols(root);
+		nodes = flat.size();
+	});
+	FlatAST flat;
+	flat.build(root);
+	flat.noteSymbols(root);
+	double flatMs = bestMillis(reps, [&](){
+		TypeAnalysis ta;
+		ta.analyze(flat);
+	});
+	Err::redirect(nullptr);
+	double rebuildMs = bestMillis(reps, [&](){
+		Arena treeArena;
+		flat.toTree(treeArena);
+	});
+
+	printf("%zu functions, %zu nodes, best of %d\n", functions, nodes, reps);
+	report("tree typeAnalysis", treeMs, nodes, "nodes");
+	report("flatten", buildMs, nodes, "nodes");
+	report("flat analyze", flatMs, nodes, "nodes");
+	report("rebuild tree", rebuildMs, nodes, "nodes");
+	return 0;
+}
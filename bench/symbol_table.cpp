@@ -0,0 +1,97 @@
+#include <cstdlib>
+#include <list>
+#include <vector>
+#include "bench.hpp"
+#include "../symbol_table.hpp"
+
+//Compares the symbol table with the one it replaced, which kept a
+// list of per-scope maps and searched them from the innermost out,
+// on scopes nested to each depth from 1 to 10,000. At every level
+// a local is declared and three names are looked up: a global, the
+// new local, and a local from halfway out.
+//
+// usage: symbol_table [reps]
+
+using namespace lake;
+
+//The replaced table, kept here for comparison. Like the original,
+// it never frees a scope it leaves.
+class ListSymbolTable{
+public:
+	void enterScope(){
+		scopes.push_front(new HashMap<NameID, SemSymbol *>());
+	}
+	void leaveScope(){ scopes.pop_front(); }
+	bool insert(SemSymbol * symbol){
+		return scopes.front()->insert(
+			std::make_pair(symbol->getNameID(), symbol)).second;
+	}
+	SemSymbol * find(NameID name){
+		for (auto scope : scopes){
+			auto found = scope->find(name);
+			if (found != scope->end()){ return found->second; }
+		}
+		return nullptr;
+	}
+private:
+	std::list<HashMap<NameID, SemSymbol *> *> scopes;
+};
+
+template <typename Table>
+static size_t nest(Table& table, 
+	const std::vector<SemSymbol *>& locals, SemSymbol * global,
+	size_t depth)
+{
+	size_t found = 0;
+	table.enterScope();
+	table.insert(global);
+	for (size_t i = 0 ; i < depth ; i++){
+		table.enterScope();
+		table.insert(locals[i]);
+		found += table.find(global->getNameID()) != nullptr;
+		found += table.find(locals[i]->getNameID()) != nullptr;
+		found += table.find(locals[i / 2]->getNameID()) != nullptr;
+	}
+	for (size_t i = 0 ; i <= depth ; i++){
+		table.leaveScope();
+	}
+	return found;
+}
+
+int main(int argc, char * argv[]){
+	int reps = argc > 1 ? atoi(argv[1]) : 5;
+	const size_t maxDepth = 10000;
+	Interner names;
+	Interner::Scope namesScope(&names);
+
+	const DataType * intType = VarType::produce(INT);
+	SemSymbol * global = new SemSymbol(VAR, intType, Interner::intern("g"));
+	std::vector<SemSymbol *> locals;
+	for (size_t i = 0 ; i < maxDepth ; i++){
+		NameID name = Interner::intern("v" + std::to_string(i));
+		locals.push_back(new SemSymbol(VAR, intType, name));
+	}
+
+	printf("best of %d; each level is a scope, a declaration and"
+		" three lookups\n", reps);
+	for (size_t depth = 1 ; depth <= maxDepth ; depth *= 10){
+		double flatMs = bestMillis(reps, [&](){
+			Arena arena;
+			SymbolTable table(arena);
+			if (nest(table, locals, global, depth) != 3 * depth){ 
+				abort(); 
+			}
+		});
+		double listMs = bestMillis(reps, [&](){
+			ListSymbolTable table;
+			if (nest(table, locals, global, depth) != 3 * depth){ 
+				abort(); 
+			}
+		});
+		std::string flat = "depth " + std::to_string(depth) + ", flat";
+		std::string list = "depth " + std::to_string(depth) + ", list";
+		report(flat.c_str(), flatMs, depth, "levels");
+		report(list.c_str(), listMs, depth, "levels");
+	}
+	return 0;
+}
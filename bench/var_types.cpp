@@ -0,0 +1,108 @@
+#include <cstdlib>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "bench.hpp"
+#include "../types.hpp"
+
+//Times VarType::produce, which type analysis calls for every type
+// node and literal, against the locked list it replaced. Each call
+// asks for one of the common types (depth 0 to 2). The same calls
+// are then made from several threads at once, by default one per
+// core; with a single core that would only time the scheduler, so
+// it is skipped.
+//
+// usage: var_types [calls] [threads] [reps]
+
+using namespace lake;
+
+//The replaced lookup, kept here for comparison: a linear scan of
+// every type made so far, under one lock
+class ListTypes{
+public:
+	class Entry{
+	public:
+		BaseType base;
+		size_t depth;
+	};
+	const Entry * produce(BaseType base, size_t depth){
+		std::lock_guard<std::mutex> guard(lock);
+		for (const Entry& entry : entries){
+			if (entry.depth == depth && entry.base == base){ 
+				return &entry; 
+			}
+		}
+		entries.push_back(Entry{base, depth});
+		return &entries.back();
+	}
+private:
+	std::list<Entry> entries;
+	std::mutex lock;
+};
+
+static const BaseType BASES[] = { INT, BOOL, VOID, STR };
+
+template <typename Produce>
+static void calls(size_t count, Produce produce){
+	for (size_t i = 0 ; i < count ; i++){
+		produce(BASES[i % 4], i % 3);
+	}
+}
+
+//Run body on each of threads threads at once
+template <typename Body>
+static void onThreads(size_t threads, Body body){
+	std::vector<std::thread> workers;
+	for (size_t t = 0 ; t < threads ; t++){
+		workers.emplace_back(body);
+	}
+	for (auto& worker : workers){ worker.join(); }
+}
+
+int main(int argc, char * argv[]){
+	size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000000;
+	size_t threads = argc > 2 ? strtoul(argv[2], nullptr, 10) 
+		: std::thread::hardware_concurrency();
+	int reps = argc > 3 ? atoi(argv[3]) : 5;
+
+	ListTypes list;
+	//Every type is made before timing starts
+	calls(12, [&](BaseType base, size_t depth){ 
+		VarType::produce(base, depth); 
+		list.produce(base, depth);
+	});
+	//Each thread keeps the results in a sink of its own
+	auto table = [&](){
+		volatile const void * sink = nullptr;
+		calls(count, [&](BaseType base, size_t depth){
+			sink = VarType::produce(base, depth);
+		});
+	};
+	auto locked = [&](){
+		volatile const void * sink = nullptr;
+		calls(count, [&](BaseType base, size_t depth){
+			sink = list.produce(base, depth);
+		});
+	};
+
+	double tableMs = bestMillis(reps, table);
+	double listMs = bestMillis(reps, locked);
+	printf("%zu calls per thread, best of %d\n", count, reps);
+	report("table", tableMs, count, "calls");
+	report("locked list", listMs, count, "calls");
+	if (threads < 2){ return 0; }
+
+	double tableThreadsMs = bestMillis(reps, [&](){
+		onThreads(threads, table);
+	});
+	double listThreadsMs = bestMillis(reps, [&](){
+		onThreads(threads, locked);
+	});
+	std::string onN = " on " + std::to_string(threads) + " threads";
+	report(("table" + onN).c_str(), tableThreadsMs, 
+		count * threads, "calls");
+	report(("locked list" + onN).c_str(), listThreadsMs, 
+		count * threads, "calls");
+	return 0;
+}
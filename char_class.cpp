@@ -0,0 +1,232 @@
+#include <cstdlib>
+#include <cstring>
+#include "char_class.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LAKE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace lake{
+
+typedef size_t (*RunFn)(const char * from, const char * end);
+
+//One implementation of every CharClass run
+class Kernels{
+public:
+	RunFn blank;
+	RunFn word;
+	RunFn digit;
+	RunFn line;
+	RunFn string;
+	const char * name;
+};
+
+static bool isBlank(unsigned char c){ return c == ' ' || c == '\t'; }
+static bool isDigit(unsigned char c){ return c >= '0' && c <= '9'; }
+static bool isWord(unsigned char c){
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+		|| isDigit(c) || c == '_';
+}
+static bool isLine(unsigned char c){ return c != '\n'; }
+static bool isString(unsigned char c){
+	return c != '\n' && c != '"' && c != '\\';
+}
+
+template <bool (*IN)(unsigned char)>
+static size_t scalarRun(const char * from, const char * end){
+	const char * cur = from;
+	while (cur < end && IN(static_cast<unsigned char>(*cur))){ cur++; }
+	return static_cast<size_t>(cur - from);
+}
+
+static const Kernels scalarKernels = {
+	scalarRun<isBlank>, scalarRun<isWord>, scalarRun<isDigit>,
+	scalarRun<isLine>, scalarRun<isString>, "scalar"
+};
+
+#ifdef LAKE_X86_KERNELS
+
+//Each mask function sets bit i when byte i is in the class. A
+// block is scanned until a byte outside the class turns up, and
+// the tail that does not fill a block is finished byte by byte.
+
+//Bytes in [lo, hi], using a signed compare after shifting lo
+// down to -128
+static inline __m128i inRange16(__m128i x, char lo, char hi){
+	__m128i shifted = _mm_add_epi8(x,
+		_mm_set1_epi8(static_cast<char>(0x80 - lo)));
+	return _mm_cmplt_epi8(shifted,
+		_mm_set1_epi8(static_cast<char>(-128 + (hi - lo + 1))));
+}
+
+static inline unsigned blankMask16(__m128i x){
+	__m128i hit = _mm_or_si128(
+		_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')),
+		_mm_cmpeq_epi8(x, _mm_set1_epi8('\t')));
+	return static_cast<unsigned>(_mm_movemask_epi8(hit));
+}
+
+static inline unsigned wordMask16(__m128i x){
+	//Folding to lower case makes one letter range do for both
+	__m128i lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+	__m128i hit = _mm_or_si128(
+		_mm_or_si128(inRange16(lower, 'a', 'z'), inRange16(x, '0', '9')),
+		_mm_cmpeq_epi8(x, _mm_set1_epi8('_')));
+	return static_cast<unsigned>(_mm_movemask_epi8(hit));
+}
+
+static inline unsigned digitMask16(__m128i x){
+	return static_cast<unsigned>(_mm_movemask_epi8(inRange16(x, '0', '9')));
+}
+
+static inline unsigned lineMask16(__m128i x){
+	__m128i miss = _mm_cmpeq_epi8(x, _mm_set1_epi8('\n'));
+	return ~static_cast<unsigned>(_mm_movemask_epi8(miss)) & 0xFFFFu;
+}
+
+static inline unsigned stringMask16(__m128i x){
+	__m128i miss = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')),
+			_mm_cmpeq_epi8(x, _mm_set1_epi8('"'))),
+		_mm_cmpeq_epi8(x, _mm_set1_epi8('\\')));
+	return ~static_cast<unsigned>(_mm_movemask_epi8(miss)) & 0xFFFFu;
+}
+
+template <unsigned (*MASK)(__m128i), bool (*IN)(unsigned char)>
+static size_t sse2Run(const char * from, const char * end){
+	const char * cur = from;
+	while (end - cur >= 16){
+		__m128i block = _mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(cur));
+		unsigned hits = MASK(block);
+		if (hits != 0xFFFFu){
+			return static_cast<size_t>(cur - from)
+				+ static_cast<size_t>(__builtin_ctz(~hits));
+		}
+		cur += 16;
+	}
+	return static_cast<size_t>(cur - from) + scalarRun<IN>(cur, end);
+}
+
+static const Kernels sse2Kernels = {
+	sse2Run<blankMask16, isBlank>, sse2Run<wordMask16, isWord>,
+	sse2Run<digitMask16, isDigit>, sse2Run<lineMask16, isLine>,
+	sse2Run<stringMask16, isString>, "sse2"
+};
+
+#define LAKE_AVX2 __attribute__((target("avx2")))
+
+LAKE_AVX2 static inline __m256i inRange32(__m256i x, char lo, char hi){
+	__m256i shifted = _mm256_add_epi8(x,
+		_mm256_set1_epi8(static_cast<char>(0x80 - lo)));
+	return _mm256_cmpgt_epi8(
+		_mm256_set1_epi8(static_cast<char>(-128 + (hi - lo + 1))),
+		shifted);
+}
+
+LAKE_AVX2 static inline unsigned blankMask32(__m256i x){
+	__m256i hit = _mm256_or_si256(
+		_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')),
+		_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t')));
+	return static_cast<unsigned>(_mm256_movemask_epi8(hit));
+}
+
+LAKE_AVX2 static inline unsigned wordMask32(__m256i x){
+	__m256i lower = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+	__m256i hit = _mm256_or_si256(
+		_mm256_or_si256(inRange32(lower, 'a', 'z'), inRange32(x, '0', '9')),
+		_mm256_cmpeq_epi8(x, _mm256_set1_epi8('_')));
+	return static_cast<unsigned>(_mm256_movemask_epi8(hit));
+}
+
+LAKE_AVX2 static inline unsigned digitMask32(__m256i x){
+	return static_cast<unsigned>(
+		_mm256_movemask_epi8(inRange32(x, '0', '9')));
+}
+
+LAKE_AVX2 static inline unsigned lineMask32(__m256i x){
+	__m256i miss = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n'));
+	return ~static_cast<unsigned>(_mm256_movemask_epi8(miss));
+}
+
+LAKE_AVX2 static inline unsigned stringMask32(__m256i x){
+	__m256i miss = _mm256_or_si256(
+		_mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n')),
+			_mm256_cmpeq_epi8(x, _mm256_set1_epi8('"'))),
+		_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\\')));
+	return ~static_cast<unsigned>(_mm256_movemask_epi8(miss));
+}
+
+template <unsigned (*MASK)(__m256i), bool (*IN)(unsigned char)>
+LAKE_AVX2 static size_t avx2Run(const char * from, const char * end){
+	const char * cur = from;
+	while (end - cur >= 32){
+		__m256i block = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i *>(cur));
+		unsigned hits = MASK(block);
+		if (hits != 0xFFFFFFFFu){
+			return static_cast<size_t>(cur - from)
+				+ static_cast<size_t>(__builtin_ctz(~hits));
+		}
+		cur += 32;
+	}
+	return static_cast<size_t>(cur - from) + scalarRun<IN>(cur, end);
+}
+
+static const Kernels avx2Kernels = {
+	avx2Run<blankMask32, isBlank>, avx2Run<wordMask32, isWord>,
+	avx2Run<digitMask32, isDigit>, avx2Run<lineMask32, isLine>,
+	avx2Run<stringMask32, isString>, "avx2"
+};
+
+#endif
+
+static const Kernels * chooseKernels(){
+	const char * forced = getenv("LAKEC_SIMD");
+	if (forced != nullptr && strcmp(forced, "scalar") == 0){
+		return &scalarKernels;
+	}
+#ifdef LAKE_X86_KERNELS
+	__builtin_cpu_init();
+	bool avx2 = __builtin_cpu_supports("avx2");
+	if (forced != nullptr && strcmp(forced, "sse2") == 0){
+		return &sse2Kernels;
+	}
+	if (avx2){ return &avx2Kernels; }
+	return &sse2Kernels;
+#else
+	return &scalarKernels;
+#endif
+}
+
+static const Kernels& kernels(){
+	static const Kernels * chosen = chooseKernels();
+	return *chosen;
+}
+
+size_t CharClass::blankRun(const char * from, const char * end){
+	return kernels().blank(from, end);
+}
+
+size_t CharClass::wordRun(const char * from, const char * end){
+	return kernels().word(from, end);
+}
+
+size_t CharClass::digitRun(const char * from, const char * end){
+	return kernels().digit(from, end);
+}
+
+size_t CharClass::lineRun(const char * from, const char * end){
+	return kernels().line(from, end);
+}
+
+size_t CharClass::stringRun(const char * from, const char * end){
+	return kernels().string(from, end);
+}
+
+const char * CharClass::kernelName(){
+	return kernels().name;
+}
+
+} //End namespace lake
@@ -0,0 +1,34 @@
+#ifndef LAKE_CHAR_CLASS_HPP
+#define LAKE_CHAR_CLASS_HPP
+
+#include <cstddef>
+
+namespace lake{
+
+//Measures runs of one character class, many bytes at a time. The
+// fastest kernel the CPU supports (AVX2, then SSE2, then plain
+// C++) is chosen the first time any of these is used. Setting
+// LAKEC_SIMD to "scalar", "sse2" or "avx2" forces a kernel, which
+// is how the kernels are checked against each other. No kernel
+// reads outside [from, end).
+class CharClass{
+public:
+	//Each returns the length of the run starting at from
+	// ' ' and '\t'
+	static size_t blankRun(const char * from, const char * end);
+	// letters, digits and '_'
+	static size_t wordRun(const char * from, const char * end);
+	// '0' to '9'
+	static size_t digitRun(const char * from, const char * end);
+	// anything but '\n', i.e. the rest of a comment
+	static size_t lineRun(const char * from, const char * end);
+	// anything but '\n', '"' and '\\', i.e. plain string text
+	static size_t stringRun(const char * from, const char * end);
+
+	//"avx2", "sse2" or "scalar"
+	static const char * kernelName();
+};
+
+} //End namespace lake
+
+#endif
@@ -0,0 +1,449 @@
+#include <iostream>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include "driver.hpp"
+#include "exp_builder.hpp"
+#include "flat_ast.hpp"
+#include "scanner.hpp"
+#include "symbol_table.hpp"
+#include "token_buffer.hpp"
+#include "types.hpp"
+
+namespace lake{
+
+//Every node of the tree, and every list in it, is placed in
+// astArena, so the whole tree goes away when the arena does. Node
+// locations come from the SourceManager installed on this thread.
+// With shareExps, repeated expressions share nodes (see ExpBuilder).
+static ProgramNode * parse(Scanner& scanner, Arena& astArena, 
+	bool shareExps)
+{
+	ProgramNode * root = NULL;
+	scanner.noteLocations(SourceManager::installed());
+	ExpBuilder exps(astArena, shareExps);
+	lake::Parser parser(scanner, &root, astArena, exps);
+	int errCode = parser.parse();
+	if (errCode != 0){ return NULL; }
+
+	return root;
+}
+
+//True if the source holds a binary token dump (see TokenBuffer)
+// instead of Lake text
+static bool isTokenDump(const SourceFile& src){
+	return src.inMemory() && TokenBuffer::isDump(src.data(), src.size());
+}
+
+//Sources are scanned ahead of parsing when they are scanned in
+// parallel, or loaded when they are already token dumps
+static bool needsTokenBuffer(
+	const SourceFile& src, const DriverOptions& opts)
+{
+	return opts.lexThreads > 1 || isTokenDump(src);
+}
+
+static bool fillTokenBuffer(
+	TokenBuffer& buffer, SourceFile& src, 
+	const DriverOptions& opts, PassTimings * timings)
+{
+	if (!isTokenDump(src)){
+		buffer.scan(src, opts.lexThreads, opts.scanner, timings);
+		return true;
+	}
+	if (!buffer.load(src.data(), src.size())){
+		Err::out() << "Error: Malformed token dump\n";
+		return false;
+	}
+	return true;
+}
+
+static void writeTokenStream(
+	SourceFile& src, const char * outPath, 
+	const DriverOptions& opts)
+{
+	if (outPath == nullptr){
+		std::string msg = "No tokens output file given";
+		throw new InternalError(msg.c_str());
+	}
+
+	std::ostream * out = opts.stdoutStream;
+	std::ofstream outStream;
+	if (strcmp(outPath, "--") != 0){
+		outStream.open(outPath, std::ios::out | std::ios::binary);
+		if (!outStream.good()){
+			std::string msg = "Bad output file ";
+			msg += outPath;
+			throw new InternalError(msg.c_str());
+		}
+		out = &outStream;
+	}
+
+	if (!opts.binaryTokens && !needsTokenBuffer(src, opts)){
+		src.rewind();
+		Scanner scanner(src, opts.scanner);
+		scanner.outputTokens(*out);
+		return;
+	}
+	TokenBuffer buffer;
+	if (!fillTokenBuffer(buffer, src, opts, nullptr)){ return; }
+	if (opts.binaryTokens){
+		buffer.write(*out);
+		Err::out() << buffer.diagnostics();
+	} else {
+		Scanner scanner(buffer);
+		scanner.outputTokens(*out);
+	}
+}
+
+static void unparse(
+	ASTNode * astRoot, const char * outFile, 
+	const DriverOptions& opts)
+{
+	if (outFile == nullptr){
+		throw new InternalError("Null unparse file given");
+	}
+	if (strcmp(outFile, "--") == 0){
+		astRoot->unparse(*opts.stdoutStream, 0);
+	} else {
+		std::ofstream outStream(outFile);
+		astRoot->unparse(outStream, 0);
+		outStream.close();
+	}
+}
+
+int compileFile(const char * inFile, const DriverOptions& opts){
+	SourceFile src;
+	if (!src.open(inFile)){
+		Err::out() << "Error: Bad input stream " 
+			<< inFile << std::endl;
+		return 1;
+	}
+	return compileSource(src, opts, inFile);
+}
+
+int compileStream(
+	std::istream& inStream, 
+	const DriverOptions& opts,
+	const char * name)
+{
+	SourceFile src;
+	src.useStream(&inStream);
+	return compileSource(src, opts, name);
+}
+
+//Time a scan-only pass over the input. The parser pulls tokens
+// from the scanner as it goes, so this is the only way to split
+// scanning time from parsing time without timing every token.
+static void timeScan(
+	SourceFile& src, const DriverOptions& opts, PassTimings * timings)
+{
+	timings->inputBytes = src.byteCount();
+
+	//Lexical errors are reported again by the real parse
+	std::ostream discard(nullptr);
+	Err::Redirect quiet(&discard);
+	PhaseTimer timer(timings, SCAN_PHASE);
+	src.rewind();
+	Scanner scanner(src, opts.scanner);
+	timings->tokens = scanner.countTokens();
+}
+
+//Scan and parse the whole source into astArena. Returns false if
+// the source could not be scanned at all; after a syntax error,
+// root is null. With shareExps, repeated expressions share nodes.
+static bool scanAndParse(SourceFile& src, const DriverOptions& opts, 
+	bool shareExps, PassTimings * timings, Arena& astArena, 
+	ProgramNode *& root)
+{
+	if (needsTokenBuffer(src, opts)){
+		//Scanning is its own pass here, so it can be timed
+		// directly
+		TokenBuffer buffer;
+		bool filled;
+		{
+			PhaseTimer timer(timings, SCAN_PHASE);
+			filled = fillTokenBuffer(buffer, src, opts, timings);
+		}
+		if (!filled){ return false; }
+		if (timings != nullptr){
+			timings->inputBytes = src.byteCount();
+			timings->tokens = buffer.size() - 1;
+		}
+		PhaseTimer timer(timings, PARSE_PHASE);
+		Scanner scanner(buffer);
+		root = parse(scanner, astArena, shareExps);
+	} else {
+		if (timings != nullptr){ timeScan(src, opts, timings); }
+		{
+			PhaseTimer timer(timings, PARSE_PHASE);
+			src.rewind();
+			Scanner scanner(src, opts.scanner);
+			root = parse(scanner, astArena, shareExps);
+		}
+		if (timings != nullptr){
+			timings->discount(PARSE_PHASE, 
+				timings->wall(SCAN_PHASE), 
+				timings->cpu(SCAN_PHASE));
+		}
+	}
+	return true;
+}
+
+//Map the AST file at path, if there is one and it was written for
+// exactly this source. The file stays mapped by astFile.
+static bool loadAST(FlatAST& flat, SourceFile& astFile, 
+	const SourceFile& src, const char * path)
+{
+	if (!src.inMemory()){ return false; }
+	if (!astFile.open(path) || !astFile.inMemory()){ return false; }
+	return flat.load(astFile.data(), astFile.size(), 
+		src.data(), src.size());
+}
+
+//Save the AST of src to path. The file is written beside path and
+// renamed over it, so another run that has the old file mapped is
+// not disturbed.
+static void writeAST(const FlatAST& flat, const SourceFile& src, 
+	const char * path)
+{
+	if (!src.inMemory()){
+		Err::out() << "Error: Cannot save the AST of a streamed input\n";
+		return;
+	}
+	std::string tmpPath = std::string(path) + ".tmp";
+	std::ofstream out(tmpPath, std::ios::out | std::ios::binary);
+	if (out.good()){
+		flat.write(out, src.data(), src.size());
+		out.close();
+	}
+	if (!out.good() || rename(tmpPath.c_str(), path) != 0){
+		remove(tmpPath.c_str());
+		Err::out() << "Error: Bad AST output file " << path << "\n";
+	}
+}
+
+//Name analysis and type checking of the tree at root, with their
+// outputs. With flatForm, the tree was rebuilt from flat, and types
+// are checked on the flat form.
+static int analyze(ProgramNode * root, FlatAST& flat, bool flatForm, 
+	const DriverOptions& opts, PassTimings * timings, Arena& astArena)
+{
+	SymbolTable symTab(astArena);
+	bool nameAnalysisOk = false;
+	{
+		PhaseTimer timer(timings, NAME_PHASE);
+		nameAnalysisOk = root->nameAnalysis(&symTab);
+	}
+	if (opts.nameAnalysisFile != NULL && nameAnalysisOk){
+		PhaseTimer timer(timings, UNPARSE_PHASE);
+		unparse(root, opts.nameAnalysisFile, opts);
+	}
+	if (!nameAnalysisOk){
+		if (opts.doTypeChecking){
+			Err::out() << "Name analysis Failed\n";
+		}
+		return 1;
+	}
+
+	if (opts.doTypeChecking){
+		TypeAnalysis typeAnalysis;
+		{
+			PhaseTimer timer(timings, TYPE_PHASE);
+			if (flatForm){
+				flat.noteSymbols(root);
+				typeAnalysis.analyze(flat);
+			} else {
+				root->typeAnalysis(&typeAnalysis);
+			}
+		}
+		if (!typeAnalysis.passed()){
+			Err::out() << "Type checking failed\n";
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int runPipeline(
+	SourceFile& src, 
+	const DriverOptions& opts, 
+	PassTimings * timings)
+{
+	//Every name of this compilation is interned here, and the table
+	// goes away with it
+	Interner names;
+	Interner::Scope namesScope(&names);
+	bool needsAST = opts.unparseFile != NULL 
+		|| opts.nameAnalysisFile != NULL
+		|| opts.doTypeChecking
+		|| opts.emitASTFile != NULL;
+	//The parse comes after the token output and a timed scan, and
+	// may be repeated without sharing (see below), so a stream is
+	// read into memory first
+	if (needsAST && (opts.tokensFile != NULL || timings != nullptr 
+	    || opts.hashCons)){
+		src.buffer();
+	}
+	if (opts.tokensFile != NULL){
+		try {
+			writeTokenStream(src, opts.tokensFile, opts);
+		} catch (InternalError * e){
+			Err::out() << "Error: " << e->what() << std::endl;
+		}
+	}
+	if (!needsAST){ return 0; }
+
+	// Every remaining output is fed from a single parse (but see
+	// sharing below). Each analysis runs at most once, in pipeline
+	// order, and later outputs reuse the results of the earlier
+	// passes.
+	// The tree lives in astArena and is released in one step when
+	// this compilation is done.
+	Arena astArena;
+	// Node locations are decoded through the same manager in every
+	// later pass.
+	SourceManager sources;
+	SourceManager::Scope sourcesScope(&sources);
+	try {
+		ASTNode::restartIDs();
+		size_t nodesBefore = ASTNode::constructed();
+		ProgramNode * astRoot = nullptr;
+		//An AST file made from this same source stands in for
+		// scanning and parsing, and is used where it is mapped
+		SourceFile astFile;
+		FlatAST flat;
+		bool cached = false;
+		if (opts.loadASTFile != NULL){
+			PhaseTimer timer(timings, PARSE_PHASE);
+			cached = loadAST(flat, astFile, src, opts.loadASTFile);
+			if (cached){ astRoot = flat.toTree(astArena); }
+		}
+		//Sharing is only worth it for the tree the later passes
+		// walk. Flattening copies a shared node once per use, with
+		// the location of its first occurrence.
+		bool shared = opts.hashCons && !cached && !opts.flatAST 
+			&& opts.emitASTFile == NULL;
+		if (!cached && !scanAndParse(src, opts, shared, timings, 
+		    astArena, astRoot)){
+			return 1;
+		}
+		if (timings != nullptr){
+			timings->astNodes = ASTNode::constructed() - nodesBefore;
+		}
+		if (astRoot == NULL){
+			if (opts.unparseFile != NULL 
+			    || opts.nameAnalysisFile != NULL){
+				Err::out() << "Parsing Error\n";
+			} else {
+				Err::out() << "Parsing failed\n";
+			}
+			return 1;
+		}
+
+		if (!cached && (opts.flatAST || opts.emitASTFile != NULL)){
+			flat.build(astRoot);
+		}
+		if (opts.emitASTFile != NULL && !(cached 
+		    && strcmp(opts.emitASTFile, opts.loadASTFile) == 0)){
+			writeAST(flat, src, opts.emitASTFile);
+		}
+		//The parser's tree is only needed until it is flattened.
+		// The tree the later passes use is rebuilt from the flat
+		// form in the same arena.
+		if (opts.flatAST && !cached){
+			astArena.release();
+			ASTNode::restartIDs();
+			astRoot = flat.toTree(astArena);
+		}
+
+		//Unparse before name analysis attaches any symbols
+		if (opts.unparseFile != NULL){
+			PhaseTimer timer(timings, UNPARSE_PHASE);
+			unparse(astRoot, opts.unparseFile, opts);
+		}
+
+		if (opts.nameAnalysisFile == NULL && !opts.doTypeChecking){ 
+			return 0; 
+		}
+		if (!shared){
+			return analyze(astRoot, flat, opts.flatAST || cached, 
+				opts, timings, astArena);
+		}
+		//A shared node has the location of its first occurrence and
+		// is checked once per use, so what is reported about it
+		// would be repeated, and placed wrongly. The shared tree is
+		// checked quietly, with no output and its times kept apart,
+		// and only a clean pass is kept. Anything else is parsed
+		// again without sharing and checked for real; that parse
+		// is not timed.
+		DriverOptions quietOpts = opts;
+		quietOpts.nameAnalysisFile = NULL;
+		PassTimings quietTimings;
+		std::ostringstream diagnostics;
+		int status = 1;
+		try {
+			Err::Redirect quiet(&diagnostics);
+			status = analyze(astRoot, flat, false, quietOpts, 
+				timings == nullptr ? nullptr : &quietTimings, astArena);
+		} catch (ToDoError *){
+			status = 1;
+		} catch (InternalError *){
+			status = 1;
+		}
+		if (status == 0 && diagnostics.str().empty()){
+			if (timings != nullptr){
+				timings->add(NAME_PHASE, quietTimings.wall(NAME_PHASE), 
+					quietTimings.cpu(NAME_PHASE));
+				timings->add(TYPE_PHASE, quietTimings.wall(TYPE_PHASE), 
+					quietTimings.cpu(TYPE_PHASE));
+			}
+			if (opts.nameAnalysisFile != NULL){
+				PhaseTimer timer(timings, UNPARSE_PHASE);
+				unparse(astRoot, opts.nameAnalysisFile, opts);
+			}
+			return 0;
+		}
+		astArena.release();
+		ASTNode::restartIDs();
+		SourceManager unsharedSources;
+		SourceManager::Scope unsharedScope(&unsharedSources);
+		scanAndParse(src, opts, false, nullptr, astArena, astRoot);
+		if (astRoot == NULL){
+			throw new InternalError("Reparse of a parsed source failed");
+		}
+		return analyze(astRoot, flat, false, opts, timings, astArena);
+	} catch (ToDoError * e){
+		Err::out() << "ToDo: " << e->what() << std::endl;
+		return 1;
+	} catch (InternalError * e){
+		Err::out() << "Compiler is Broken! " 
+			<< e->what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+int compileSource(
+	SourceFile& src, 
+	const DriverOptions& opts,
+	const char * name)
+{
+	if (opts.timePasses == NO_REPORT && !opts.memReport){
+		return runPipeline(src, opts, nullptr);
+	}
+	PassTimings timings;
+	timings.input = name;
+	MemStats memStats;
+	int status;
+	{
+		MemStats::Scope counting(opts.memReport ? &memStats : nullptr);
+		status = runPipeline(src, opts, 
+			opts.timePasses == NO_REPORT ? nullptr : &timings);
+	}
+	timings.report(Err::out(), opts.timePasses);
+	if (opts.memReport){ memStats.report(Err::out(), name); }
+	return status;
+}
+
+} //End namespace lake
@@ -0,0 +1,69 @@
+#ifndef LAKE_DRIVER_HPP
+#define LAKE_DRIVER_HPP
+
+#include <iostream>
+#include "hand_scanner.hpp"
+#include "timing.hpp"
+#include "memstats.hpp"
+#include "source.hpp"
+
+namespace lake{
+
+//The set of outputs requested for a single input file.
+// Output paths may be "--" to mean the stdout stream given here.
+class DriverOptions{
+public:
+	const char * tokensFile = nullptr;
+	const char * unparseFile = nullptr;
+	const char * nameAnalysisFile = nullptr;
+	bool doTypeChecking = false;
+	ReportFormat timePasses = NO_REPORT;
+	bool memReport = false;
+	//Threads to scan with; above 1, the whole input is scanned 
+	// into a TokenBuffer before parsing starts
+	size_t lexThreads = 1;
+	//Write -t output as a binary token dump instead of text
+	bool binaryTokens = false;
+	ScannerBackend scanner = FLEX_BACKEND;
+	//Flatten the tree right after parsing (see FlatAST) and work
+	// from the flat form: type checking runs over its arrays, and
+	// the passes that need a pointer tree get one rebuilt from it
+	bool flatAST = false;
+	//Parse repeated side-effect-free expressions in a scope into
+	// one shared node each (see ExpBuilder). Diagnostics about a
+	// shared expression point at its first occurrence.
+	bool hashCons = false;
+	//Save the tree as a binary AST file (see FlatAST)
+	const char * emitASTFile = nullptr;
+	//Use this AST file instead of scanning and parsing, if it was
+	// saved from the same source text. The tree is then worked on
+	// in flat form, as with flatAST.
+	const char * loadASTFile = nullptr;
+	std::ostream * stdoutStream = &std::cout;
+};
+
+//Run the front end over a single input file, reading it from
+// a memory mapping when the file allows it and producing each
+// requested output from one shared AST. A file holding a binary
+// token dump (see TokenBuffer) is loaded instead of scanned.
+// Diagnostics are written to Err::out(). Returns 0 if every
+// requested phase passed and 1 otherwise.
+int compileFile(const char * inFile, const DriverOptions& opts);
+
+//As compileFile, but reading the program from a seekable stream
+// (for example, a source buffer sent to the compile server). The
+// name is only used in reports.
+int compileStream(
+	std::istream& in, 
+	const DriverOptions& opts,
+	const char * name = "<input>");
+
+//As compileFile, for an already opened source
+int compileSource(
+	SourceFile& src, 
+	const DriverOptions& opts,
+	const char * name);
+
+} //End namespace lake
+
+#endif
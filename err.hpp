@@ -12,20 +12,51 @@ namespace lake{
 
 class Err{
 	public:
+	//All diagnostics go through a per-thread stream so that
+	// concurrent compilations can each capture their own
+	// output. It is std::cerr unless redirected.
+	static std::ostream& out(){ 
+		return *sink(); 
+	}
+	//Returns the stream that was in use, so that it can be put
+	// back later
+	static std::ostream * redirect(std::ostream * to){
+		std::ostream * previous = sink();
+		sink() = (to == nullptr) ? &std::cerr : to;
+		return previous;
+	}
+	//Redirects this thread's diagnostics for as long as it is in
+	// scope, then restores the stream that was in use before,
+	// which may itself be a redirection (a batch worker or a
+	// server connection capturing one compilation's output)
+	class Redirect{
+	public:
+		Redirect(std::ostream * to) : previous(redirect(to)){ }
+		~Redirect(){ sink() = previous; }
+		Redirect(const Redirect&) = delete;
+		Redirect& operator=(const Redirect&) = delete;
+	private:
+		std::ostream * previous;
+	};
 	static void report(const std::string msg){ 
-		std::cerr << msg << std::endl;
+		out() << msg << std::endl;
 	}
 	static void semanticReport(
 		size_t line, 
 		size_t col, 
 		const std::string msg
 	){
-		std::cerr << line << "," << col 
+		out() << line << "," << col 
 			<< ": " << msg << std::endl;
 	}
 	static void syntaxReport(const std::string msg){
 		lake::Err::report(" ***ERROR*** " + msg);
 	}
+	private:
+	static std::ostream *& sink(){
+		static thread_local std::ostream * current = &std::cerr;
+		return current;
+	}
 };
 
 class InternalError{
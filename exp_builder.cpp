@@ -0,0 +1,256 @@
+#include <cstring>
+#include "exp_builder.hpp"
+
+namespace lake{
+
+static uint32_t kindHash(NodeKind kind){
+	return ExpNode::mixHash(0, static_cast<uint32_t>(kind));
+}
+
+static BinaryExpNode * newBinary(Arena& arena, NodeKind kind,
+	size_t line, size_t col, ExpNode * exp1, ExpNode * exp2)
+{
+	switch(kind){
+	case PLUS_NODE:
+		return new (arena) PlusNode(line, col, exp1, exp2);
+	case MINUS_NODE:
+		return new (arena) MinusNode(line, col, exp1, exp2);
+	case TIMES_NODE:
+		return new (arena) TimesNode(line, col, exp1, exp2);
+	case DIVIDE_NODE:
+		return new (arena) DivideNode(line, col, exp1, exp2);
+	case AND_NODE:
+		return new (arena) AndNode(line, col, exp1, exp2);
+	case OR_NODE:
+		return new (arena) OrNode(line, col, exp1, exp2);
+	case EQUALS_NODE:
+		return new (arena) EqualsNode(line, col, exp1, exp2);
+	case NOT_EQUALS_NODE:
+		return new (arena) NotEqualsNode(line, col, exp1, exp2);
+	case LESS_NODE:
+		return new (arena) LessNode(line, col, exp1, exp2);
+	case GREATER_NODE:
+		return new (arena) GreaterNode(line, col, exp1, exp2);
+	case LESS_EQ_NODE:
+		return new (arena) LessEqNode(line, col, exp1, exp2);
+	case GREATER_EQ_NODE:
+		return new (arena) GreaterEqNode(line, col, exp1, exp2);
+	default:
+		throw new InternalError("Not a binary operator kind");
+	}
+}
+
+bool ExpBuilder::Key::operator==(const Key& other) const {
+	if (hash != other.hash || kind != other.kind){ return false; }
+	if (kind == STR_LIT_NODE){
+		return b == other.b && memcmp(
+			reinterpret_cast<const char *>(a),
+			reinterpret_cast<const char *>(other.a), b) == 0;
+	}
+	return a == other.a && b == other.b;
+}
+
+ExpBuilder::ExpBuilder(Arena& arenaIn, bool shareIn)
+: arena(arenaIn), share(shareIn), tablesUsed(0){ }
+
+//Tables are kept when their scope closes and cleared for the next
+// one, so that their buckets are only allocated once
+void ExpBuilder::enterScope(bool declaresNames){
+	if (!share){ return; }
+	if (!declaresNames && !scopes.empty()){
+		scopes.push_back(scopes.back());
+		return;
+	}
+	if (tablesUsed == tables.size()){ tables.emplace_back(); }
+	Table& table = tables[tablesUsed];
+	table.nodes.clear();
+	table.hashes.clear();
+	scopes.push_back(tablesUsed++);
+}
+
+void ExpBuilder::leaveScope(){
+	if (!share){ return; }
+	size_t table = scopes.back();
+	scopes.pop_back();
+	if (scopes.empty() || scopes.back() != table){
+		tablesUsed--;
+	}
+}
+
+ExpBuilder::Table * ExpBuilder::current(){
+	if (scopes.empty()){ return nullptr; }
+	return &tables[scopes.back()];
+}
+
+ExpBuilder::Key ExpBuilder::makeKey(
+	NodeKind kind, uint32_t hash, uintptr_t a, uintptr_t b)
+{
+	Key key;
+	key.hash = hash;
+	key.kind = static_cast<uint8_t>(kind);
+	key.a = a;
+	key.b = b;
+	return key;
+}
+
+bool ExpBuilder::shareable(
+	Table& table, const ExpNode * exp, uint32_t& hash)
+{
+	auto found = table.hashes.find(exp);
+	if (found == table.hashes.end()){ return false; }
+	hash = found->second;
+	return true;
+}
+
+ExpNode * ExpBuilder::find(Table& table, const Key& key){
+	auto found = table.nodes.find(key);
+	if (found == table.nodes.end()){ return nullptr; }
+	return found->second;
+}
+
+void ExpBuilder::add(Table& table, const Key& key, ExpNode * node){
+	table.nodes.emplace(key, node);
+	table.hashes.emplace(node, key.hash);
+}
+
+IdNode * ExpBuilder::id(IDToken * token){
+	Table * table = current();
+	if (table == nullptr){ return new (arena) IdNode(token); }
+	const std::string& name = token->value();
+	uint32_t hash = ExpNode::mixHash(kindHash(ID_NODE),
+		ExpNode::textHash(name.data(), name.size()));
+	Key key = makeKey(ID_NODE, hash, token->id(), 0);
+	ExpNode * res = find(*table, key);
+	if (res != nullptr){ return static_cast<IdNode *>(res); }
+	IdNode * node = new (arena) IdNode(token);
+	add(*table, key, node);
+	return node;
+}
+
+ExpNode * ExpBuilder::intLit(IntLitToken * token){
+	Table * table = current();
+	if (table == nullptr){ return new (arena) IntLitNode(token); }
+	uint32_t value = static_cast<uint32_t>(token->value());
+	uint32_t hash = ExpNode::mixHash(kindHash(INT_LIT_NODE), value);
+	Key key = makeKey(INT_LIT_NODE, hash, value, 0);
+	ExpNode * res = find(*table, key);
+	if (res != nullptr){ return res; }
+	res = new (arena) IntLitNode(token);
+	add(*table, key, res);
+	return res;
+}
+
+ExpNode * ExpBuilder::strLit(StringLitToken * token){
+	Table * table = current();
+	if (table == nullptr){ return new (arena) StrLitNode(token, arena); }
+	uint32_t hash = ExpNode::mixHash(kindHash(STR_LIT_NODE),
+		ExpNode::textHash(token->text(), token->length()));
+	Key key = makeKey(STR_LIT_NODE, hash,
+		reinterpret_cast<uintptr_t>(token->text()), token->length());
+	ExpNode * res = find(*table, key);
+	if (res != nullptr){ return res; }
+	StrLitNode * node = new (arena) StrLitNode(token, arena);
+	//The token's text goes away with the token, so the table keeps
+	// the node's copy
+	key.a = reinterpret_cast<uintptr_t>(node->getText());
+	add(*table, key, node);
+	return node;
+}
+
+ExpNode * ExpBuilder::trueLit(Token * token){
+	Table * table = current();
+	if (table == nullptr){
+		return new (arena) TrueNode(token->_line, token->_column);
+	}
+	Key key = makeKey(TRUE_NODE, kindHash(TRUE_NODE), 0, 0);
+	ExpNode * res = find(*table, key);
+	if (res != nullptr){ return res; }
+	res = new (arena) TrueNode(token->_line, token->_column);
+	add(*table, key, res);
+	return res;
+}
+
+ExpNode * ExpBuilder::falseLit(Token * token){
+	Table * table = current();
+	if (table == nullptr){
+		return new (arena) FalseNode(token->_line, token->_column);
+	}
+	Key key = makeKey(FALSE_NODE, kindHash(FALSE_NODE), 0, 0);
+	ExpNode * res = find(*table, key);
+	if (res != nullptr){ return res; }
+	res = new (arena) FalseNode(token->_line, token->_column);
+	add(*table, key, res);
+	return res;
+}
+
+ExpNode * ExpBuilder::deref(Token * op, ExpNode * tgt){
+	Table * table = current();
+	uint32_t tgtHash;
+	if (table == nullptr || !shareable(*table, tgt, tgtHash)){
+		return new (arena) DerefNode(op->_line, op->_column, tgt);
+	}
+	uint32_t hash = ExpNode::mixHash(kindHash(DEREF_NODE), tgtHash);
+	Key key = makeKey(DEREF_NODE, hash,
+		reinterpret_cast<uintptr_t>(tgt), 0);
+	ExpNode * res = find(*table, key);
+	if (res != nullptr){ return res; }
+	res = new (arena) DerefNode(op->_line, op->_column, tgt);
+	add(*table, key, res);
+	return res;
+}
+
+ExpNode * ExpBuilder::notExp(Token * op, ExpNode * exp){
+	Table * table = current();
+	uint32_t expHash;
+	if (table == nullptr || !shareable(*table, exp, expHash)){
+		return new (arena) NotNode(op->_line, op->_column, exp);
+	}
+	uint32_t hash = ExpNode::mixHash(kindHash(NOT_NODE), expHash);
+	Key key = makeKey(NOT_NODE, hash,
+		reinterpret_cast<uintptr_t>(exp), 0);
+	ExpNode * res = find(*table, key);
+	if (res != nullptr){ return res; }
+	res = new (arena) NotNode(op->_line, op->_column, exp);
+	add(*table, key, res);
+	return res;
+}
+
+ExpNode * ExpBuilder::unaryMinus(ExpNode * exp){
+	Table * table = current();
+	uint32_t expHash;
+	if (table == nullptr || !shareable(*table, exp, expHash)){
+		return new (arena) UnaryMinusNode(exp);
+	}
+	uint32_t hash = ExpNode::mixHash(kindHash(UNARY_MINUS_NODE), expHash);
+	Key key = makeKey(UNARY_MINUS_NODE, hash,
+		reinterpret_cast<uintptr_t>(exp), 0);
+	ExpNode * res = find(*table, key);
+	if (res != nullptr){ return res; }
+	res = new (arena) UnaryMinusNode(exp);
+	add(*table, key, res);
+	return res;
+}
+
+ExpNode * ExpBuilder::binary(NodeKind kind, Token * op,
+	ExpNode * exp1, ExpNode * exp2)
+{
+	Table * table = current();
+	uint32_t hash1;
+	uint32_t hash2;
+	if (table == nullptr || !shareable(*table, exp1, hash1)
+	    || !shareable(*table, exp2, hash2)){
+		return newBinary(arena, kind, op->_line, op->_column,
+			exp1, exp2);
+	}
+	uint32_t hash = ExpNode::mixHash(
+		ExpNode::mixHash(kindHash(kind), hash1), hash2);
+	Key key = makeKey(kind, hash, reinterpret_cast<uintptr_t>(exp1),
+		reinterpret_cast<uintptr_t>(exp2));
+	ExpNode * res = find(*table, key);
+	if (res != nullptr){ return res; }
+	res = newBinary(arena, kind, op->_line, op->_column, exp1, exp2);
+	add(*table, key, res);
+	return res;
+}
+
+} //End namespace lake
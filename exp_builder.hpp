@@ -0,0 +1,90 @@
+#ifndef LAKE_EXP_BUILDER_HPP
+#define LAKE_EXP_BUILDER_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "arena.hpp"
+#include "ast.hpp"
+
+namespace lake{
+
+//Builds the parser's expression nodes in an arena. With sharing on,
+// expressions are hash-consed: a side-effect-free expression that is
+// structurally identical to one already built in the same scope is
+// not built again, and the earlier node is handed back in its place.
+// The tree is then a DAG in which every distinct subexpression of a
+// scope is a single node. Assignments and calls, and expressions
+// containing them, are always built fresh.
+//
+//A function body is a scope. A block inside it is part of the
+// enclosing scope unless it declares variables, since only then can
+// a name in the block mean something else than outside it.
+//
+//A shared node keeps the location of its first occurrence, and the
+// passes visit it once per use, so diagnostics about a shared tree
+// would be repeated at the wrong place. The driver only reports
+// them from a tree built without sharing.
+class ExpBuilder{
+public:
+	ExpBuilder(Arena& arenaIn, bool shareIn);
+	ExpBuilder(const ExpBuilder&) = delete;
+	ExpBuilder& operator=(const ExpBuilder&) = delete;
+	//Scopes are opened once a block's declarations have been seen
+	void enterScope(bool declaresNames);
+	void leaveScope();
+
+	IdNode * id(IDToken * token);
+	ExpNode * intLit(IntLitToken * token);
+	ExpNode * strLit(StringLitToken * token);
+	ExpNode * trueLit(Token * token);
+	ExpNode * falseLit(Token * token);
+	ExpNode * deref(Token * op, ExpNode * tgt);
+	ExpNode * notExp(Token * op, ExpNode * exp);
+	ExpNode * unaryMinus(ExpNode * exp);
+	//kind must be one of the binary operator kinds
+	ExpNode * binary(NodeKind kind, Token * op,
+		ExpNode * exp1, ExpNode * exp2);
+private:
+	//What makes two expressions the same: their kind, and either
+	// their children, which are already shared and so compare by
+	// address, or their literal value. String literals compare by
+	// their text, held in a and b as a pointer and a length.
+	class Key{
+	public:
+		bool operator==(const Key& other) const;
+		uint32_t hash;
+		uint8_t kind;
+		uintptr_t a;
+		uintptr_t b;
+	};
+	class KeyHash{
+	public:
+		size_t operator()(const Key& key) const { return key.hash; }
+	};
+	class Table{
+	public:
+		std::unordered_map<Key, ExpNode *, KeyHash> nodes;
+		//The structural hash of every node in nodes
+		HashMap<const ExpNode *, uint32_t> hashes;
+	};
+
+	//The table of the innermost scope, or null when not sharing
+	Table * current();
+	Key makeKey(NodeKind kind, uint32_t hash, uintptr_t a, uintptr_t b);
+	//True, with its hash, if exp may be a child of a shared node
+	bool shareable(Table& table, const ExpNode * exp, uint32_t& hash);
+	ExpNode * find(Table& table, const Key& key);
+	void add(Table& table, const Key& key, ExpNode * node);
+
+	Arena& arena;
+	bool share;
+	std::vector<Table> tables;
+	size_t tablesUsed;
+	//For each open scope, the index of the table it uses
+	std::vector<size_t> scopes;
+};
+
+} //End namespace lake
+
+#endif
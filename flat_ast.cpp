@@ -0,0 +1,755 @@
+#include <cstring>
+#include "ast_visitor.hpp"
+#include "flat_ast.hpp"
+#include "symbol_table.hpp"
+
+namespace lake{
+
+//Appends a pointer tree to a FlatAST in postorder. The nodes
+// finished so far whose parent has not been added yet wait on
+// pending, so a node's children are always the top of it.
+class FlatBuilder : public ASTVisitor<FlatBuilder>{
+public:
+	FlatBuilder(FlatAST& flatIn) : flat(flatIn), retType(0){ }
+
+	void visitNode(ASTNode * node){
+		size_t first = pending.size();
+		visitChildren(node);
+		finish(node, first, 0);
+	}
+
+	void visitFnDeclNode(FnDeclNode * node){
+		size_t first = pending.size();
+		visit(node->getReturnTypeNode());
+		FlatRef outerRetType = retType;
+		retType = pending.back();
+		visit(node->getDeclaredID());
+		visit(node->getFormals());
+		visit(node->getBody());
+		retType = outerRetType;
+		finish(node, first, 0);
+	}
+
+	void visitReturnStmtNode(ReturnStmtNode * node){
+		size_t first = pending.size();
+		visitChildren(node);
+		finish(node, first, retType);
+	}
+
+	void visitTypeNode(TypeNode * node){
+		finish(node, pending.size(),
+			static_cast<uint32_t>(node->getPtrDepth()));
+	}
+
+	void visitIdNode(IdNode * node){
+		finish(node, pending.size(), flat.addName(node->getNameID()));
+	}
+
+	void visitIntLitNode(IntLitNode * node){
+		finish(node, pending.size(),
+			static_cast<uint32_t>(node->getValue()));
+	}
+
+	void visitStrLitNode(StrLitNode * node){
+		uint32_t literal = flat.addLiteral(
+			node->getText(), node->getLength());
+		finish(node, pending.size(), literal);
+	}
+private:
+	//Add node, whose children are on pending from first up
+	void finish(ASTNode * node, size_t first, uint32_t payload){
+		auto kids = pending.begin() + static_cast<std::ptrdiff_t>(first);
+		flat.childStore.insert(flat.childStore.end(), kids, pending.end());
+		pending.erase(kids, pending.end());
+		pending.push_back(flat.add(node->getKind(), node->getLoc(), payload));
+	}
+
+	FlatAST& flat;
+	std::vector<FlatRef> pending;
+	//The return type node of the function being flattened
+	FlatRef retType;
+};
+
+//Collects the types of the symbols attached to ID nodes. IDs are
+// leaves, so they are met in the same order as in postorder.
+class SymbolTypeCollector : public ASTVisitor<SymbolTypeCollector>{
+public:
+	SymbolTypeCollector(std::vector<const DataType *>& typesIn)
+	: types(typesIn){ }
+	void visitIdNode(IdNode * node){
+		SemSymbol * sym = node->getSymbol();
+		types.push_back(sym == nullptr ? nullptr : sym->getType());
+	}
+private:
+	std::vector<const DataType *>& types;
+};
+
+FlatAST::FlatAST() : childStartStore(1, 0), literalStartStore(1, 0){
+	useStores();
+}
+
+void FlatAST::build(ProgramNode * root){
+	if (size() != 0){
+		throw new InternalError("Building into a non-empty FlatAST");
+	}
+	FlatBuilder(*this).visit(root);
+	nameSlots.clear();
+	useStores();
+}
+
+void FlatAST::useStores(){
+	kinds = Seq<const uint8_t>(kindStore.data(), kindStore.size());
+	childStart = Seq<const uint32_t>(
+		childStartStore.data(), childStartStore.size());
+	children = Seq<const FlatRef>(childStore.data(), childStore.size());
+	locs = Seq<const SourceLoc>(locStore.data(), locStore.size());
+	payloads = Seq<const uint32_t>(payloadStore.data(), payloadStore.size());
+	literals = Seq<const char>(literalStore.data(), literalStore.size());
+	literalStarts = Seq<const uint32_t>(
+		literalStartStore.data(), literalStartStore.size());
+}
+
+void FlatAST::noteSymbols(ProgramNode * root){
+	symbolTypes.clear();
+	SymbolTypeCollector(symbolTypes).visit(root);
+}
+
+FlatRef FlatAST::add(NodeKind kindIn, SourceLoc locIn, uint32_t payloadIn){
+	if (kindStore.size() >= UINT32_MAX || childStore.size() >= UINT32_MAX){
+		throw new InternalError("Tree too large for a FlatAST");
+	}
+	FlatRef ref = static_cast<FlatRef>(kindStore.size());
+	kindStore.push_back(static_cast<uint8_t>(kindIn));
+	locStore.push_back(locIn);
+	payloadStore.push_back(payloadIn);
+	childStartStore.push_back(static_cast<uint32_t>(childStore.size()));
+	return ref;
+}
+
+uint32_t FlatAST::addLiteral(const char * text, size_t length){
+	if (literalStore.size() + length >= UINT32_MAX){
+		throw new InternalError("Literals too large for a FlatAST");
+	}
+	uint32_t literal = static_cast<uint32_t>(literalStartStore.size() - 1);
+	literalStore.append(text, length);
+	literalStartStore.push_back(static_cast<uint32_t>(literalStore.size()));
+	return literal;
+}
+
+uint32_t FlatAST::addName(NameID id){
+	auto found = nameSlots.find(id);
+	if (found != nameSlots.end()){ return found->second; }
+	uint32_t slot = static_cast<uint32_t>(names.size());
+	nameSlots.emplace(id, slot);
+	names.push_back(id);
+	return slot;
+}
+
+size_t FlatAST::getLine(FlatRef node) const{
+	return SourceManager::current().line(locs[node]);
+}
+
+size_t FlatAST::getCol(FlatRef node) const{
+	return SourceManager::current().col(locs[node]);
+}
+
+FlatRef FlatAST::subtreeStart(FlatRef node) const{
+	while (childCount(node) > 0){
+		node = childrenOf(node)[0];
+	}
+	return node;
+}
+
+//A list node holding the given children
+template <typename List, typename Elt>
+static List * rebuildList(Arena& arena,
+	const std::vector<ASTNode *>& built,
+	const FlatRef * kids, size_t count)
+{
+	SeqBuilder<Elt *> elts(arena);
+	for (size_t i = 0 ; i < count ; i++){
+		elts.push_back(static_cast<Elt *>(built[kids[i]]));
+	}
+	return new (arena) List(elts.freeze());
+}
+
+//A binary expression node
+template <typename Binary>
+static ASTNode * rebuildBinary(Arena& arena, size_t line, size_t col,
+	const std::vector<ASTNode *>& built, const FlatRef * kids)
+{
+	return new (arena) Binary(line, col,
+		static_cast<ExpNode *>(built[kids[0]]),
+		static_cast<ExpNode *>(built[kids[1]]));
+}
+
+ProgramNode * FlatAST::toTree(Arena& arena) const{
+	std::vector<ASTNode *> built(size(), nullptr);
+	for (FlatRef node = 0 ; node < size() ; node++){
+		const FlatRef * kids = childrenOf(node);
+		size_t count = childCount(node);
+		//Nodes are built with no position and then given their
+		// saved location, rather than decoding it only to have
+		// the constructor encode it again
+		size_t line = 0;
+		size_t col = 0;
+		//The child at idx, as the class its parent expects
+		auto kid = [&](size_t idx){ return built[kids[idx]]; };
+		ASTNode * res = nullptr;
+		switch(kind(node)){
+		case PROGRAM_NODE:
+			res = new (arena) ProgramNode(
+				static_cast<DeclListNode *>(kid(0)));
+			break;
+		case DECL_LIST_NODE:
+			res = rebuildList<DeclListNode, DeclNode>(
+				arena, built, kids, count);
+			break;
+		case VAR_DECL_LIST_NODE:
+			res = rebuildList<VarDeclListNode, VarDeclNode>(
+				arena, built, kids, count);
+			break;
+		case FORMALS_LIST_NODE:
+			res = rebuildList<FormalsListNode, FormalDeclNode>(
+				arena, built, kids, count);
+			break;
+		case EXP_LIST_NODE:
+			res = rebuildList<ExpListNode, ExpNode>(
+				arena, built, kids, count);
+			break;
+		case STMT_LIST_NODE:
+			res = rebuildList<StmtListNode, StmtNode>(
+				arena, built, kids, count);
+			break;
+		case FN_BODY_NODE:
+			res = new (arena) FnBodyNode(line, col,
+				static_cast<VarDeclListNode *>(kid(0)),
+				static_cast<StmtListNode *>(kid(1)));
+			break;
+		case VAR_DECL_NODE:
+			res = new (arena) VarDeclNode(
+				static_cast<TypeNode *>(kid(0)),
+				static_cast<IdNode *>(kid(1)));
+			break;
+		case FORMAL_DECL_NODE:
+			res = new (arena) FormalDeclNode(
+				static_cast<TypeNode *>(kid(0)),
+				static_cast<IdNode *>(kid(1)));
+			break;
+		case FN_DECL_NODE:
+			res = new (arena) FnDeclNode(
+				static_cast<TypeNode *>(kid(0)),
+				static_cast<IdNode *>(kid(1)),
+				static_cast<FormalsListNode *>(kid(2)),
+				static_cast<FnBodyNode *>(kid(3)));
+			break;
+		case INT_NODE:
+		case BOOL_NODE:
+		case VOID_NODE:
+			{
+			TypeNode * type;
+			if (kind(node) == INT_NODE){
+				type = new (arena) IntNode(line, col);
+			} else if (kind(node) == BOOL_NODE){
+				type = new (arena) BoolNode(line, col);
+			} else {
+				type = new (arena) VoidNode(line, col);
+			}
+			type->setPtrDepth(payload(node));
+			res = type;
+			break;
+			}
+		case DEREF_NODE:
+			res = new (arena) DerefNode(line, col,
+				static_cast<ExpNode *>(kid(0)));
+			break;
+		case ID_NODE:
+			{
+			IDToken token(line, col, name(payload(node)));
+			res = new (arena) IdNode(&token);
+			break;
+			}
+		case INT_LIT_NODE:
+			{
+			IntLitToken token(line, col, static_cast<int>(payload(node)));
+			res = new (arena) IntLitNode(&token);
+			break;
+			}
+		case STR_LIT_NODE:
+			{
+			StringLitToken token(line, col,
+				literalText(payload(node)),
+				literalLength(payload(node)));
+			res = new (arena) StrLitNode(&token, arena);
+			break;
+			}
+		case TRUE_NODE:
+			res = new (arena) TrueNode(line, col);
+			break;
+		case FALSE_NODE:
+			res = new (arena) FalseNode(line, col);
+			break;
+		case ASSIGN_NODE:
+			res = new (arena) AssignNode(line, col,
+				static_cast<ExpNode *>(kid(0)),
+				static_cast<ExpNode *>(kid(1)));
+			break;
+		case CALL_EXP_NODE:
+			res = new (arena) CallExpNode(
+				static_cast<IdNode *>(kid(0)),
+				static_cast<ExpListNode *>(kid(1)));
+			break;
+		case UNARY_MINUS_NODE:
+			res = new (arena) UnaryMinusNode(
+				static_cast<ExpNode *>(kid(0)));
+			break;
+		case NOT_NODE:
+			res = new (arena) NotNode(line, col,
+				static_cast<ExpNode *>(kid(0)));
+			break;
+		case PLUS_NODE:
+			res = rebuildBinary<PlusNode>(arena, line, col, built, kids);
+			break;
+		case MINUS_NODE:
+			res = rebuildBinary<MinusNode>(arena, line, col, built, kids);
+			break;
+		case TIMES_NODE:
+			res = rebuildBinary<TimesNode>(arena, line, col, built, kids);
+			break;
+		case DIVIDE_NODE:
+			res = rebuildBinary<DivideNode>(arena, line, col, built, kids);
+			break;
+		case AND_NODE:
+			res = rebuildBinary<AndNode>(arena, line, col, built, kids);
+			break;
+		case OR_NODE:
+			res = rebuildBinary<OrNode>(arena, line, col, built, kids);
+			break;
+		case EQUALS_NODE:
+			res = rebuildBinary<EqualsNode>(arena, line, col, built, kids);
+			break;
+		case NOT_EQUALS_NODE:
+			res = rebuildBinary<NotEqualsNode>(arena, line, col, built, kids);
+			break;
+		case LESS_NODE:
+			res = rebuildBinary<LessNode>(arena, line, col, built, kids);
+			break;
+		case GREATER_NODE:
+			res = rebuildBinary<GreaterNode>(arena, line, col, built, kids);
+			break;
+		case LESS_EQ_NODE:
+			res = rebuildBinary<LessEqNode>(arena, line, col, built, kids);
+			break;
+		case GREATER_EQ_NODE:
+			res = rebuildBinary<GreaterEqNode>(arena, line, col, built, kids);
+			break;
+		case ASSIGN_STMT_NODE:
+			res = new (arena) AssignStmtNode(
+				static_cast<AssignNode *>(kid(0)));
+			break;
+		case POST_INC_STMT_NODE:
+			res = new (arena) PostIncStmtNode(
+				static_cast<ExpNode *>(kid(0)));
+			break;
+		case POST_DEC_STMT_NODE:
+			res = new (arena) PostDecStmtNode(
+				static_cast<ExpNode *>(kid(0)));
+			break;
+		case READ_STMT_NODE:
+			res = new (arena) ReadStmtNode(
+				static_cast<ExpNode *>(kid(0)));
+			break;
+		case WRITE_STMT_NODE:
+			res = new (arena) WriteStmtNode(
+				static_cast<ExpNode *>(kid(0)));
+			break;
+		case IF_STMT_NODE:
+			res = new (arena) IfStmtNode(line, col,
+				static_cast<ExpNode *>(kid(0)),
+				static_cast<VarDeclListNode *>(kid(1)),
+				static_cast<StmtListNode *>(kid(2)));
+			break;
+		case IF_ELSE_STMT_NODE:
+			res = new (arena) IfElseStmtNode(
+				static_cast<ExpNode *>(kid(0)),
+				static_cast<VarDeclListNode *>(kid(1)),
+				static_cast<StmtListNode *>(kid(2)),
+				static_cast<VarDeclListNode *>(kid(3)),
+				static_cast<StmtListNode *>(kid(4)));
+			break;
+		case WHILE_STMT_NODE:
+			res = new (arena) WhileStmtNode(line, col,
+				static_cast<ExpNode *>(kid(0)),
+				static_cast<VarDeclListNode *>(kid(1)),
+				static_cast<StmtListNode *>(kid(2)));
+			break;
+		case CALL_STMT_NODE:
+			res = new (arena) CallStmtNode(
+				static_cast<CallExpNode *>(kid(0)));
+			break;
+		case RETURN_STMT_NODE:
+			res = new (arena) ReturnStmtNode(line, col,
+				count == 0 ? nullptr : static_cast<ExpNode *>(kid(0)));
+			break;
+		case NUM_NODE_KINDS:
+			break;
+		}
+		if (res == nullptr){
+			throw new InternalError("FlatAST node of unknown kind");
+		}
+		res->setLoc(getLoc(node));
+		built[node] = res;
+	}
+	if (size() == 0){ return nullptr; }
+	return static_cast<ProgramNode *>(built[root()]);
+}
+
+//"LAKEAST" and a format version
+static const char AST_MAGIC[8] = {'L','A','K','E','A','S','T','\x02'};
+//Reads back differently if the byte order does not match
+static const uint32_t AST_BYTE_ORDER = 0x01020304;
+
+//The words of an AST file's header, after the magic
+enum ASTHeaderWord{
+	BYTE_ORDER_WORD, SOURCE_SIZE_LO_WORD, SOURCE_SIZE_HI_WORD,
+	SOURCE_HASH_LO_WORD, SOURCE_HASH_HI_WORD,
+	NODE_COUNT_WORD, CHILD_COUNT_WORD, LITERAL_COUNT_WORD,
+	LITERAL_BYTES_WORD, NAME_COUNT_WORD, NAME_BYTES_WORD,
+	LINE_COUNT_WORD, NODE_KINDS_WORD,
+	NUM_HEADER_WORDS
+};
+
+//FNV-1a, to tell whether an AST file was made from this source
+static uint64_t sourceHash(const char * source, size_t size){
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0 ; i < size ; i++){
+		hash ^= static_cast<unsigned char>(source[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+//The header words that identify the source text
+static void sourceKey(const char * source, size_t size, uint32_t * header){
+	uint64_t hash = sourceHash(source, size);
+	uint64_t size64 = size;
+	header[SOURCE_SIZE_LO_WORD] = static_cast<uint32_t>(size64);
+	header[SOURCE_SIZE_HI_WORD] = static_cast<uint32_t>(size64 >> 32);
+	header[SOURCE_HASH_LO_WORD] = static_cast<uint32_t>(hash);
+	header[SOURCE_HASH_HI_WORD] = static_cast<uint32_t>(hash >> 32);
+}
+
+//Bytes taken by count elements of type T, padded to 4 bytes
+template <typename T>
+static size_t paddedBytes(size_t count){
+	return (count * sizeof(T) + 3) / 4 * 4;
+}
+
+template <typename T>
+static void putArray(std::ostream& out, const T * data, size_t count){
+	static const char padding[4] = {0, 0, 0, 0};
+	size_t bytes = count * sizeof(T);
+	out.write(reinterpret_cast<const char *>(data), 
+		static_cast<std::streamsize>(bytes));
+	out.write(padding, 
+		static_cast<std::streamsize>(paddedBytes<T>(count) - bytes));
+}
+
+void FlatAST::write(std::ostream& out, 
+	const char * source, size_t sourceSize) const
+{
+	//Names are saved as text, since NameIDs only hold in one process
+	std::string nameText;
+	std::vector<uint32_t> nameStarts(1, 0);
+	for (NameID id : names){
+		nameText += Interner::name(id);
+		nameStarts.push_back(static_cast<uint32_t>(nameText.size()));
+	}
+	const std::vector<SourceLoc>& lines = 
+		SourceManager::current().getLineStarts();
+
+	uint32_t header[NUM_HEADER_WORDS];
+	header[BYTE_ORDER_WORD] = AST_BYTE_ORDER;
+	sourceKey(source, sourceSize, header);
+	header[NODE_COUNT_WORD] = static_cast<uint32_t>(size());
+	header[CHILD_COUNT_WORD] = static_cast<uint32_t>(children.size());
+	header[LITERAL_COUNT_WORD] = static_cast<uint32_t>(literalStarts.size() - 1);
+	header[LITERAL_BYTES_WORD] = static_cast<uint32_t>(literals.size());
+	header[NAME_COUNT_WORD] = static_cast<uint32_t>(names.size());
+	header[NAME_BYTES_WORD] = static_cast<uint32_t>(nameText.size());
+	header[LINE_COUNT_WORD] = static_cast<uint32_t>(lines.size());
+	header[NODE_KINDS_WORD] = NUM_NODE_KINDS;
+
+	out.write(AST_MAGIC, sizeof(AST_MAGIC));
+	putArray(out, header, NUM_HEADER_WORDS);
+	putArray(out, kinds.begin(), kinds.size());
+	putArray(out, childStart.begin(), childStart.size());
+	putArray(out, children.begin(), children.size());
+	putArray(out, locs.begin(), locs.size());
+	putArray(out, payloads.begin(), payloads.size());
+	putArray(out, literalStarts.begin(), literalStarts.size());
+	putArray(out, literals.begin(), literals.size());
+	putArray(out, nameStarts.data(), nameStarts.size());
+	putArray(out, nameText.data(), nameText.size());
+	putArray(out, lines.data(), lines.size());
+	out.flush();
+}
+
+static bool isTypeKind(NodeKind kind){
+	return kind >= INT_NODE && kind <= VOID_NODE;
+}
+
+static bool isExpKind(NodeKind kind){
+	return kind >= DEREF_NODE && kind <= GREATER_EQ_NODE;
+}
+
+static bool isStmtKind(NodeKind kind){
+	return kind >= ASSIGN_STMT_NODE && kind <= RETURN_STMT_NODE;
+}
+
+//Whether a node of the given kind may have children of these
+// kinds, i.e. whether toTree can cast each child to the class it
+// expects
+static bool childrenFit(NodeKind kind, const NodeKind * kids, size_t count){
+	//All of the children are of a kind accepted by fits
+	auto all = [&](bool (*fits)(NodeKind)){
+		for (size_t i = 0 ; i < count ; i++){
+			if (!fits(kids[i])){ return false; }
+		}
+		return true;
+	};
+	switch(kind){
+	case PROGRAM_NODE:
+		return count == 1 && kids[0] == DECL_LIST_NODE;
+	case DECL_LIST_NODE:
+		return all([](NodeKind kid){
+			return kid == VAR_DECL_NODE || kid == FN_DECL_NODE; });
+	case VAR_DECL_LIST_NODE:
+		return all([](NodeKind kid){ return kid == VAR_DECL_NODE; });
+	case FORMALS_LIST_NODE:
+		return all([](NodeKind kid){ return kid == FORMAL_DECL_NODE; });
+	case EXP_LIST_NODE:
+		return all(isExpKind);
+	case STMT_LIST_NODE:
+		return all(isStmtKind);
+	case FN_BODY_NODE:
+		return count == 2 && kids[0] == VAR_DECL_LIST_NODE 
+			&& kids[1] == STMT_LIST_NODE;
+	case VAR_DECL_NODE:
+	case FORMAL_DECL_NODE:
+		return count == 2 && isTypeKind(kids[0]) && kids[1] == ID_NODE;
+	case FN_DECL_NODE:
+		return count == 4 && isTypeKind(kids[0]) && kids[1] == ID_NODE
+			&& kids[2] == FORMALS_LIST_NODE && kids[3] == FN_BODY_NODE;
+	case INT_NODE:
+	case BOOL_NODE:
+	case VOID_NODE:
+	case ID_NODE:
+	case INT_LIT_NODE:
+	case STR_LIT_NODE:
+	case TRUE_NODE:
+	case FALSE_NODE:
+		return count == 0;
+	case DEREF_NODE:
+	case UNARY_MINUS_NODE:
+	case NOT_NODE:
+	case POST_INC_STMT_NODE:
+	case POST_DEC_STMT_NODE:
+	case READ_STMT_NODE:
+	case WRITE_STMT_NODE:
+		return count == 1 && isExpKind(kids[0]);
+	case ASSIGN_NODE:
+	case PLUS_NODE:
+	case MINUS_NODE:
+	case TIMES_NODE:
+	case DIVIDE_NODE:
+	case AND_NODE:
+	case OR_NODE:
+	case EQUALS_NODE:
+	case NOT_EQUALS_NODE:
+	case LESS_NODE:
+	case GREATER_NODE:
+	case LESS_EQ_NODE:
+	case GREATER_EQ_NODE:
+		return count == 2 && isExpKind(kids[0]) && isExpKind(kids[1]);
+	case CALL_EXP_NODE:
+		return count == 2 && kids[0] == ID_NODE 
+			&& kids[1] == EXP_LIST_NODE;
+	case ASSIGN_STMT_NODE:
+		return count == 1 && kids[0] == ASSIGN_NODE;
+	case CALL_STMT_NODE:
+		return count == 1 && kids[0] == CALL_EXP_NODE;
+	case IF_STMT_NODE:
+	case WHILE_STMT_NODE:
+		return count == 3 && isExpKind(kids[0]) 
+			&& kids[1] == VAR_DECL_LIST_NODE && kids[2] == STMT_LIST_NODE;
+	case IF_ELSE_STMT_NODE:
+		return count == 5 && isExpKind(kids[0]) 
+			&& kids[1] == VAR_DECL_LIST_NODE && kids[2] == STMT_LIST_NODE
+			&& kids[3] == VAR_DECL_LIST_NODE && kids[4] == STMT_LIST_NODE;
+	case RETURN_STMT_NODE:
+		return count == 0 || (count == 1 && isExpKind(kids[0]));
+	case NUM_NODE_KINDS:
+		break;
+	}
+	return false;
+}
+
+//Whether an array of offsets never goes backwards
+static bool ascending(const Seq<const uint32_t>& starts){
+	for (size_t i = 1 ; i < starts.size() ; i++){
+		if (starts[i] < starts[i - 1]){ return false; }
+	}
+	return true;
+}
+
+//One pass over the arrays, checking everything the readers of a
+// FlatAST rely on without checking it themselves: that the nodes
+// form one tree, numbered in postorder, that each node is of a
+// known kind and has the children its kind calls for, and that
+// every payload that is an index is in range
+bool FlatAST::wellFormed(size_t nameCount) const{
+	if (childStart[0] != 0 || !ascending(childStart)
+	    || !ascending(literalStarts)){
+		return false;
+	}
+	size_t literalCount = literalStarts.size() - 1;
+	//The first node of each node's subtree. In postorder, each
+	// child's subtree starts just after the one before it, and
+	// the last child comes just before its parent.
+	std::vector<FlatRef> first(size());
+	std::vector<NodeKind> kidKinds;
+	for (FlatRef node = 0 ; node < size() ; node++){
+		if (kinds[node] >= NUM_NODE_KINDS){ return false; }
+		const FlatRef * kids = childrenOf(node);
+		size_t count = childCount(node);
+		kidKinds.clear();
+		for (size_t i = 0 ; i < count ; i++){
+			if (kids[i] >= node){ return false; }
+			kidKinds.push_back(kind(kids[i]));
+		}
+		for (size_t i = 0 ; i < count ; i++){
+			FlatRef next = i + 1 == count ? node : first[kids[i + 1]];
+			if (kids[i] + 1 != next){ return false; }
+		}
+		first[node] = count == 0 ? node : first[kids[0]];
+		if (!childrenFit(kind(node), kidKinds.data(), count)){
+			return false;
+		}
+		uint32_t payload = payloads[node];
+		switch(kind(node)){
+		case ID_NODE:
+			if (payload >= nameCount){ return false; }
+			break;
+		case STR_LIT_NODE:
+			if (payload >= literalCount){ return false; }
+			break;
+		case RETURN_STMT_NODE:
+			if (payload >= node || !isTypeKind(kind(payload))){ 
+				return false; 
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	return first[root()] == 0 && kind(root()) == PROGRAM_NODE;
+}
+
+//Hands out the arrays of a mapped AST file in order, failing if
+// the file is too short to hold the next one
+class ASTFileReader{
+public:
+	ASTFileReader(const char * data, size_t size)
+	: pos(data), end(data + size){ }
+	template <typename T>
+	bool array(Seq<const T>& res, size_t count){
+		size_t bytes = paddedBytes<T>(count);
+		if (static_cast<size_t>(end - pos) < bytes){ return false; }
+		res = Seq<const T>(reinterpret_cast<const T *>(pos), count);
+		pos += bytes;
+		return true;
+	}
+	bool atEnd() const { return pos == end; }
+private:
+	const char * pos;
+	const char * end;
+};
+
+bool FlatAST::load(const char * data, size_t size, 
+	const char * source, size_t sourceSize)
+{
+	if (this->size() != 0){
+		throw new InternalError("Loading into a non-empty FlatAST");
+	}
+	//The arrays are read in place, so they must be aligned
+	if (size < sizeof(AST_MAGIC) 
+	    || memcmp(data, AST_MAGIC, sizeof(AST_MAGIC)) != 0
+	    || reinterpret_cast<uintptr_t>(data) % alignof(uint32_t) != 0){
+		return false;
+	}
+	ASTFileReader reader(data + sizeof(AST_MAGIC), size - sizeof(AST_MAGIC));
+	Seq<const uint32_t> header;
+	//A file from a build with other node kinds would be read
+	// with the wrong meanings
+	if (!reader.array(header, NUM_HEADER_WORDS)
+	    || header[BYTE_ORDER_WORD] != AST_BYTE_ORDER
+	    || header[NODE_KINDS_WORD] != NUM_NODE_KINDS){
+		return false;
+	}
+	uint32_t key[NUM_HEADER_WORDS];
+	sourceKey(source, sourceSize, key);
+	for (size_t word = SOURCE_SIZE_LO_WORD ; word <= SOURCE_HASH_HI_WORD ; word++){
+		if (header[word] != key[word]){ return false; }
+	}
+
+	size_t nodeCount = header[NODE_COUNT_WORD];
+	size_t literalCount = header[LITERAL_COUNT_WORD];
+	size_t nameCount = header[NAME_COUNT_WORD];
+	Seq<const uint8_t> fileKinds;
+	Seq<const uint32_t> fileChildStart, fileChildren, fileLocs, filePayloads;
+	Seq<const uint32_t> fileLiteralStarts, fileNameStarts, fileLines;
+	Seq<const char> fileLiterals, fileNames;
+	if (nodeCount == 0
+	    || !reader.array(fileKinds, nodeCount)
+	    || !reader.array(fileChildStart, nodeCount + 1)
+	    || !reader.array(fileChildren, header[CHILD_COUNT_WORD])
+	    || !reader.array(fileLocs, nodeCount)
+	    || !reader.array(filePayloads, nodeCount)
+	    || !reader.array(fileLiteralStarts, literalCount + 1)
+	    || !reader.array(fileLiterals, header[LITERAL_BYTES_WORD])
+	    || !reader.array(fileNameStarts, nameCount + 1)
+	    || !reader.array(fileNames, header[NAME_BYTES_WORD])
+	    || !reader.array(fileLines, header[LINE_COUNT_WORD])
+	    || !reader.atEnd()
+	    || fileChildStart.back() != fileChildren.size()
+	    || fileLiteralStarts.back() != fileLiterals.size()
+	    || fileNameStarts.back() != fileNames.size()
+	    || fileLines.empty() || fileLines[0] != NO_LOC){
+		return false;
+	}
+
+	kinds = fileKinds;
+	childStart = fileChildStart;
+	children = fileChildren;
+	locs = fileLocs;
+	payloads = filePayloads;
+	literalStarts = fileLiteralStarts;
+	literals = fileLiterals;
+	//A damaged file whose source key still matches must not lead
+	// the passes that read the arrays out of bounds
+	if (!wellFormed(nameCount) || !ascending(fileNameStarts)
+	    || !ascending(fileLines)){
+		useStores();
+		return false;
+	}
+	names.reserve(nameCount);
+	for (size_t i = 0 ; i < nameCount ; i++){
+		names.push_back(Interner::intern(fileNames.begin() + fileNameStarts[i], 
+			fileNameStarts[i + 1] - fileNameStarts[i]));
+	}
+	SourceManager::current().loadLines(fileLines.begin(), fileLines.size());
+	return true;
+}
+
+} //End namespace lake
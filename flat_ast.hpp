@@ -0,0 +1,150 @@
+#ifndef LAKE_FLAT_AST_HPP
+#define LAKE_FLAT_AST_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "arena.hpp"
+#include "ast.hpp"
+#include "seq.hpp"
+
+namespace lake{
+
+//The index of a node in a FlatAST
+typedef uint32_t FlatRef;
+
+//A whole tree in structure-of-arrays form. Nodes are numbered in
+// postorder, so every node comes after all of its children and the
+// root is the last node. A pass that only needs the results of a
+// node's children can therefore run front to back over the arrays
+// in one loop, with no recursion and no pointer chasing.
+//
+//A node's children are listed in source order (the order
+// ASTVisitor::visitChildren uses), and the children of node i are
+// the entries of the children array from childStart[i] up to
+// childStart[i+1]. What a node's payload holds depends on its kind:
+// - ID_NODE: the index of the identifier in the name table
+// - INT_LIT_NODE: the value
+// - STR_LIT_NODE: the index of its text in the literal pool
+// - INT_NODE, BOOL_NODE, VOID_NODE: the pointer depth
+// - RETURN_STMT_NODE: the return type node of the enclosing
+//   function
+// - any other kind: 0
+//
+//The types of symbols that name analysis attaches to ID nodes are
+// kept in a side table, in the order the ID nodes appear.
+//
+//A FlatAST can be saved as a binary AST file and mapped back in
+// later by another run. The arrays are then read where they lie in
+// the mapping: the only work done on load is interning the name
+// table and restoring the line table that locations decode with. A
+// file holds a header, then each array in turn, padded to 4 bytes:
+// kinds, childStart, children, locs, payloads, the literal pool
+// (its offsets, then its text), the name table (likewise) and the
+// line starts. The header gives the format version, the byte order
+// (a file from a machine with the other byte order is rejected),
+// the array sizes, the number of node kinds, and the size and hash
+// of the source text the tree was parsed from, so that a file is
+// only used for the same source. The arrays are checked in one pass
+// on load, and a file that does not hold a well-formed tree is
+// rejected like a file for another source.
+class FlatAST{
+public:
+	FlatAST();
+	FlatAST(const FlatAST&) = delete;
+	FlatAST& operator=(const FlatAST&) = delete;
+	//Fill an empty FlatAST from a pointer tree
+	void build(ProgramNode * root);
+	//Write a binary AST file for a tree parsed from the given
+	// source text. Locations are saved with the lines of the
+	// SourceManager installed on this thread.
+	void write(std::ostream& out, 
+		const char * source, size_t sourceSize) const;
+	//Fill an empty FlatAST from a binary AST file, which must stay
+	// mapped while the FlatAST is in use. The file's lines are
+	// loaded into the SourceManager installed on this thread.
+	// Returns false, and leaves both unchanged, if the data is not
+	// an AST file for this source text.
+	bool load(const char * data, size_t size,
+		const char * source, size_t sourceSize);
+	//Record the types of the symbols attached to the ID nodes of
+	// a tree, which must have the shape of this one (for example,
+	// one made by toTree). IDs without a symbol get a null type.
+	void noteSymbols(ProgramNode * root);
+	//Rebuild the pointer tree, for passes that still need one.
+	// Nodes are placed in arena and take their locations from the
+	// SourceManager installed on this thread. No symbols are
+	// attached.
+	ProgramNode * toTree(Arena& arena) const;
+
+	size_t size() const { return kinds.size(); }
+	FlatRef root() const { return static_cast<FlatRef>(size() - 1); }
+	NodeKind kind(FlatRef node) const {
+		return static_cast<NodeKind>(kinds[node]);
+	}
+	SourceLoc getLoc(FlatRef node) const { return locs[node]; }
+	size_t getLine(FlatRef node) const;
+	size_t getCol(FlatRef node) const;
+	uint32_t payload(FlatRef node) const { return payloads[node]; }
+	size_t childCount(FlatRef node) const {
+		return childStart[node + 1] - childStart[node];
+	}
+	//The node's children, in source order
+	const FlatRef * childrenOf(FlatRef node) const {
+		return children.begin() + childStart[node];
+	}
+	//The first node of the subtree rooted at node. The subtree is
+	// every node from there up to node itself.
+	FlatRef subtreeStart(FlatRef node) const;
+
+	//The identifier an ID node's payload stands for
+	NameID name(uint32_t idx) const { return names[idx]; }
+	//The text of a string literal, including its quotes
+	const char * literalText(uint32_t literal) const {
+		return literals.begin() + literalStarts[literal];
+	}
+	size_t literalLength(uint32_t literal) const {
+		return literalStarts[literal + 1] - literalStarts[literal];
+	}
+	//The type of the symbol of the idx'th ID node in postorder
+	const DataType * symbolType(size_t idx) const {
+		return symbolTypes[idx];
+	}
+private:
+	friend class FlatBuilder;
+	FlatRef add(NodeKind kindIn, SourceLoc locIn, uint32_t payloadIn);
+	uint32_t addLiteral(const char * text, size_t length);
+	uint32_t addName(NameID id);
+	void useStores();
+	//Whether the arrays, as read from a file, form a tree that the
+	// other members can read safely
+	bool wellFormed(size_t nameCount) const;
+
+	//What the accessors read: either the stores below, for a tree
+	// built here, or a mapped AST file
+	Seq<const uint8_t> kinds;
+	Seq<const uint32_t> childStart;
+	Seq<const FlatRef> children;
+	Seq<const SourceLoc> locs;
+	Seq<const uint32_t> payloads;
+	Seq<const char> literals;
+	Seq<const uint32_t> literalStarts;
+
+	std::vector<uint8_t> kindStore;
+	std::vector<uint32_t> childStartStore;
+	std::vector<FlatRef> childStore;
+	std::vector<SourceLoc> locStore;
+	std::vector<uint32_t> payloadStore;
+	std::string literalStore;
+	std::vector<uint32_t> literalStartStore;
+
+	std::vector<NameID> names;
+	//Where each NameID is in names, while building
+	HashMap<NameID, uint32_t> nameSlots;
+	std::vector<const DataType *> symbolTypes;
+};
+
+} //End namespace lake
+
+#endif
@@ -0,0 +1,264 @@
+#include <climits>
+#include <cstring>
+#include <string>
+#include "char_class.hpp"
+#include "hand_scanner.hpp"
+#include "scanner.hpp"
+
+namespace lake{
+
+using TokenKind = Parser::token;
+
+static bool isLetter(unsigned char c){
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static bool isDigit(unsigned char c){
+	return c >= '0' && c <= '9';
+}
+
+//The characters that may follow a backslash in a string literal
+static bool isEscape(unsigned char c){
+	switch(c){
+		case 'n': case 't': case '\'': case '"': case '?': case '\\':
+			return true;
+	}
+	return false;
+}
+
+HandScanner::HandScanner(const char * begin, const char * endIn,
+	size_t firstLine, Arena& arena)
+: pos(begin), end(endIn), lineNum(firstLine), charNum(1),
+  tokenArena(arena){
+}
+
+int HandScanner::noArg(int tag, size_t length, Token *& token){
+	token = new (tokenArena) NoArgToken(lineNum, charNum, tag);
+	charNum += length;
+	pos += length;
+	return tag;
+}
+
+int HandScanner::next(Token *& token){
+	while (pos < end){
+		unsigned char c = static_cast<unsigned char>(*pos);
+		bool more = pos + 1 < end;
+		unsigned char c2 = more ? static_cast<unsigned char>(pos[1]) : 0;
+		switch(c){
+		case ' ': case '\t':
+			{
+			size_t blanks = CharClass::blankRun(pos, end);
+			charNum += blanks;
+			pos += blanks;
+			continue;
+			}
+		case '\n':
+			lineNum++;
+			charNum = 1;
+			pos++;
+			continue;
+		case '\r':
+			if (more && c2 == '\n'){
+				lineNum++;
+				charNum = 1;
+				pos += 2;
+				continue;
+			}
+			break;
+		//Comments do not move charNum, as in lake.l
+		case '/':
+			if (!more || c2 != '/'){
+				return noArg(TokenKind::SLASH, 1, token);
+			}
+			pos += CharClass::lineRun(pos, end);
+			continue;
+		case '#':
+			pos += CharClass::lineRun(pos, end);
+			continue;
+		case '{': return noArg(TokenKind::LCURLY, 1, token);
+		case '}': return noArg(TokenKind::RCURLY, 1, token);
+		case '@': return noArg(TokenKind::DEREF, 1, token);
+		case '(': return noArg(TokenKind::LPAREN, 1, token);
+		case ')': return noArg(TokenKind::RPAREN, 1, token);
+		case ';': return noArg(TokenKind::SEMICOLON, 1, token);
+		case ',': return noArg(TokenKind::COMMA, 1, token);
+		case '*': return noArg(TokenKind::STAR, 1, token);
+		case '+':
+			if (c2 == '+'){ return noArg(TokenKind::CROSSCROSS, 2, token); }
+			return noArg(TokenKind::CROSS, 1, token);
+		case '-':
+			if (c2 == '-'){ return noArg(TokenKind::DASHDASH, 2, token); }
+			return noArg(TokenKind::DASH, 1, token);
+		case '!':
+			if (c2 == '='){ return noArg(TokenKind::NOTEQUALS, 2, token); }
+			return noArg(TokenKind::NOT, 1, token);
+		case '=':
+			if (c2 == '='){ return noArg(TokenKind::EQUALS, 2, token); }
+			return noArg(TokenKind::ASSIGN, 1, token);
+		case '<':
+			if (c2 == '='){ return noArg(TokenKind::LESSEQ, 2, token); }
+			return noArg(TokenKind::LESS, 1, token);
+		case '>':
+			if (c2 == '='){ return noArg(TokenKind::GREATEREQ, 2, token); }
+			return noArg(TokenKind::GREATER, 1, token);
+		case '&':
+			if (c2 == '&'){ return noArg(TokenKind::AND, 2, token); }
+			break;
+		case '|':
+			if (c2 == '|'){ return noArg(TokenKind::OR, 2, token); }
+			break;
+		case '"':
+			{
+			int tag = scanString(token);
+			if (tag != TokenKind::END){ return tag; }
+			continue;
+			}
+		default:
+			if (isLetter(c)){ return scanWord(token); }
+			if (isDigit(c)){ return scanNumber(token); }
+			break;
+		}
+
+		//Anything else is a single illegal character. yytext is
+		// a C string in lake.l, so a NUL adds nothing to the message.
+		std::string msg = "Illegal character ";
+		if (c != '\0'){ msg += static_cast<char>(c); }
+		Scanner::error(static_cast<int>(lineNum),
+			static_cast<int>(charNum), msg);
+		charNum++;
+		pos++;
+	}
+	token = nullptr;
+	return TokenKind::END;
+}
+
+int HandScanner::scanWord(Token *& token){
+	const char * start = pos;
+	size_t len = 1 + CharClass::wordRun(pos + 1, end);
+	const char * stop = start + len;
+
+	int keyword = TokenKind::END;
+	switch(len){
+	case 2:
+		if (memcmp(start, "if", 2) == 0){ keyword = TokenKind::IF; }
+		break;
+	case 3:
+		if (memcmp(start, "int", 3) == 0){ keyword = TokenKind::INT; }
+		break;
+	case 4:
+		if (memcmp(start, "bool", 4) == 0){ keyword = TokenKind::BOOL; }
+		else if (memcmp(start, "void", 4) == 0){ keyword = TokenKind::VOID; }
+		else if (memcmp(start, "true", 4) == 0){ keyword = TokenKind::TRUE; }
+		else if (memcmp(start, "else", 4) == 0){ keyword = TokenKind::ELSE; }
+		else if (memcmp(start, "read", 4) == 0){ keyword = TokenKind::READ; }
+		break;
+	case 5:
+		if (memcmp(start, "false", 5) == 0){ keyword = TokenKind::FALSE; }
+		else if (memcmp(start, "while", 5) == 0){ keyword = TokenKind::WHILE; }
+		else if (memcmp(start, "write", 5) == 0){ keyword = TokenKind::WRITE; }
+		break;
+	case 6:
+		if (memcmp(start, "return", 6) == 0){ keyword = TokenKind::RETURN; }
+		break;
+	}
+	if (keyword != TokenKind::END){ return noArg(keyword, len, token); }
+
+	token = new (tokenArena) IDToken(lineNum, charNum,
+		Interner::intern(start, len));
+	charNum += len;
+	pos = stop;
+	return TokenKind::ID;
+}
+
+int HandScanner::scanNumber(Token *& token){
+	//Decode and check for overflow in the same pass, saturating
+	// at INT_MAX
+	const char * start = pos;
+	const char * stop = pos + CharClass::digitRun(pos, end);
+	long long value = 0;
+	bool overflow = false;
+	for (const char * digit = start ; digit < stop && !overflow ; digit++){
+		value = value * 10 + (*digit - '0');
+		if (value > INT_MAX){ overflow = true; }
+	}
+	pos = stop;
+	int intVal = static_cast<int>(value);
+	if (overflow){
+		Scanner::warn(0, 0, "Integer literal too large; using max value");
+		intVal = INT_MAX;
+	}
+	token = new (tokenArena) IntLitToken(lineNum, charNum, intVal);
+	charNum += static_cast<size_t>(pos - start);
+	return TokenKind::INTLITERAL;
+}
+
+size_t HandScanner::validRun(const char * from) const{
+	const char * cur = from;
+	while (cur < end){
+		cur += CharClass::stringRun(cur, end);
+		if (cur + 1 < end && *cur == '\\'
+		    && isEscape(static_cast<unsigned char>(cur[1]))){
+			cur += 2;
+			continue;
+		}
+		break;
+	}
+	return static_cast<size_t>(cur - from);
+}
+
+//The four string rules of lake.l compete on match length, with
+// ties going to the earlier rule. Only a well-formed literal gives
+// a token; the others are reported and skipped, in which case
+// END is returned.
+int HandScanner::scanString(Token *& token){
+	const char * body = pos + 1;
+	const char * after = body + validRun(body);
+	size_t len;
+	const char * msg;
+	if (after < end && *after == '"'){
+		len = static_cast<size_t>(after + 1 - pos);
+		token = new (tokenArena) StringLitToken(lineNum, charNum,
+			pos, len);
+		charNum += len;
+		pos += len;
+		return TokenKind::STRINGLITERAL;
+	} else if (after < end && *after == '\\'){
+		if (after + 1 < end && after[1] != '\n'){
+			//A bad escape. Either the literal is closed later on
+			// the line, or it runs on unterminated; take whichever
+			// reading is longer.
+			const char * rest = after + 2;
+			const char * unterminated = rest + validRun(rest);
+			if (unterminated < end && *unterminated == '\\'){
+				unterminated++;
+			}
+			const char * closed = rest;
+			while (closed < end && *closed != '\n' && *closed != '"'){
+				closed++;
+			}
+			if (closed < end && *closed == '"'
+			    && closed + 1 >= unterminated){
+				len = static_cast<size_t>(closed + 1 - pos);
+				msg = "string literal with bad escaped character ignored";
+			} else {
+				len = static_cast<size_t>(unterminated - pos);
+				msg = "unterminated string literal with bad"
+				" escaped character ignored";
+			}
+		} else {
+			len = static_cast<size_t>(after + 1 - pos);
+			msg = "unterminated string literal with bad"
+			" escaped character ignored";
+		}
+	} else {
+		len = static_cast<size_t>(after - pos);
+		msg = "unterminated string literal ignored";
+	}
+	Scanner::error(static_cast<int>(lineNum),
+		static_cast<int>(charNum), msg);
+	charNum += len;
+	pos += len;
+	return TokenKind::END;
+}
+
+} //End namespace lake
@@ -0,0 +1,50 @@
+#ifndef LAKE_HAND_SCANNER_HPP
+#define LAKE_HAND_SCANNER_HPP
+
+#include <cstddef>
+#include "arena.hpp"
+#include "tokens.hpp"
+
+namespace lake{
+
+//The implementations of Lake's lexical rules a Scanner can use
+enum ScannerBackend{
+	FLEX_BACKEND, HAND_BACKEND
+};
+
+//A hand-written scanner for in-memory sources that follows the
+// rules in lake.l exactly: the same token kinds, positions and
+// diagnostics, in the same order. Lexemes are never copied out of
+// the source. Identifiers are interned straight from the buffer,
+// and string literal tokens point into it, so the source must
+// outlive the tokens. Integer literals are decoded and checked for
+// overflow in a single pass. Blanks, comments, words, digits and
+// string text are skipped with the CharClass kernels. Tokens are
+// placed in the given arena.
+class HandScanner{
+public:
+	HandScanner(const char * begin, const char * end,
+		size_t firstLine, Arena& arena);
+	//Scan the next token, returning its kind (a
+	// lake::Parser::token value) and setting token to it. At the
+	// end of the input the kind is END and token is null.
+	int next(Token *& token);
+private:
+	int scanWord(Token *& token);
+	int scanNumber(Token *& token);
+	int scanString(Token *& token);
+	int noArg(int tag, size_t length, Token *& token);
+	//Length of the longest run of plain characters and valid
+	// escapes in a string literal, starting at from
+	size_t validRun(const char * from) const;
+
+	const char * pos;
+	const char * end;
+	size_t lineNum;
+	size_t charNum;
+	Arena& tokenArena;
+};
+
+} //End namespace lake
+
+#endif
@@ -0,0 +1,73 @@
+#include <cstring>
+#include "err.hpp"
+#include "interner.hpp"
+
+namespace lake{
+
+static thread_local Interner * activeInterner = nullptr;
+
+bool Interner::NameKey::operator==(const NameKey& other) const {
+	return len == other.len && memcmp(text, other.text, len) == 0;
+}
+
+size_t Interner::NameKeyHash::operator()(const NameKey& key) const {
+	//FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0 ; i < key.len ; i++){
+		hash ^= static_cast<unsigned char>(key.text[i]);
+		hash *= 1099511628211ull;
+	}
+	return static_cast<size_t>(hash);
+}
+
+Interner::Interner(){ }
+
+NameID Interner::add(const char * text, size_t len){
+	NameKey key = {text, len};
+	auto found = ids.find(key);
+	if (found != ids.end()){ return found->second; }
+
+	size_t id = names.size();
+	if (id > UINT32_MAX){
+		throw new InternalError("Too many distinct identifiers");
+	}
+	names.emplace_back(text, len);
+	const std::string& stored = names.back();
+	NameKey storedKey = {stored.data(), len};
+	ids.emplace(storedKey, static_cast<NameID>(id));
+	return static_cast<NameID>(id);
+}
+
+Interner& Interner::current(){
+	if (activeInterner == nullptr){
+		throw new InternalError("No identifier table installed");
+	}
+	return *activeInterner;
+}
+
+NameID Interner::intern(const char * text, size_t len){
+	return current().add(text, len);
+}
+
+const std::string& Interner::name(NameID id){
+	return current().text(id);
+}
+
+size_t Interner::size(){
+	return current().count();
+}
+
+Interner * Interner::installed(){
+	return activeInterner;
+}
+
+Interner::Scope::Scope(Interner * interner)
+: previous(activeInterner){
+	activeInterner = interner;
+}
+
+Interner::Scope::~Scope(){
+	activeInterner = previous;
+}
+
+} //End namespace lake
@@ -0,0 +1,86 @@
+#ifndef LAKE_INTERNER_HPP
+#define LAKE_INTERNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+namespace lake{
+
+//A dense integer standing for one identifier's text
+typedef uint32_t NameID;
+
+//One compilation's identifier table. The scanner interns each 
+// identifier once, and from then on names are compared, hashed
+// and stored as NameIDs. IDs are never reused, and the text behind
+// an ID never moves, so references returned by name() stay valid
+// for the life of the table. 
+//
+//The static functions use the table installed on the calling
+// thread with Interner::Scope. The driver installs a fresh table
+// for each compilation, so a long-running process (the compile
+// server, or a batch) only holds the names of the compilations in
+// progress, and its threads never share a table or a lock. A table
+// is not safe to use from several threads at once; a scan split
+// across threads interns each piece into a table of its own and
+// merges them (see TokenBuffer). One table holds at most 2^32
+// names.
+class Interner{
+public:
+	Interner();
+	Interner(const Interner&) = delete;
+	Interner& operator=(const Interner&) = delete;
+	//Moving a table keeps its strings where they are
+	Interner(Interner&&) = default;
+
+	//Intern into, and look up in, this table
+	NameID add(const char * text, size_t len);
+	const std::string& text(NameID id) const { return names[id]; }
+	size_t count() const { return names.size(); }
+
+	//Intern into, and look up in, the installed table
+	static NameID intern(const char * text, size_t len);
+	static NameID intern(const std::string& text){
+		return intern(text.c_str(), text.size());
+	}
+	static const std::string& name(NameID id);
+	static size_t size();
+
+	//The table installed on the calling thread, if any
+	static Interner * installed();
+
+	//Installs a table on the calling thread for its lifetime
+	class Scope{
+	public:
+		Scope(Interner * interner);
+		~Scope();
+	private:
+		Interner * previous;
+	};
+private:
+	//A view of interned text, used as the lookup key. It points 
+	// into the stored string, so the text is only kept once.
+	class NameKey{
+	public:
+		const char * text;
+		size_t len;
+		bool operator==(const NameKey& other) const;
+	};
+	class NameKeyHash{
+	public:
+		size_t operator()(const NameKey& key) const;
+	};
+
+	static Interner& current();
+
+	std::unordered_map<NameKey, NameID, NameKeyHash> ids;
+	//A deque never moves its elements as it grows, so neither
+	// the strings nor their text move
+	std::deque<std::string> names;
+};
+
+} //End namespace lake
+
+#endif
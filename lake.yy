@@ -9,9 +9,11 @@
 %token-table
 
 %code requires{
-   #include <list>
+   #include "arena.hpp"
+   #include "seq.hpp"
    #include "tokens.hpp"
    #include "ast.hpp"
+   #include "exp_builder.hpp"
    namespace lake {
       class Scanner;
    }
@@ -29,6 +31,8 @@
 
 %parse-param { lake::Scanner  &scanner  }
 %parse-param { lake::ProgramNode** root }
+%parse-param { lake::Arena& arena }
+%parse-param { lake::ExpBuilder& exps }
 
 %code{
    #include <iostream>
@@ -39,7 +43,7 @@
    #include "scanner.hpp"
 
 #undef yylex
-#define yylex scanner.yylex
+#define yylex scanner.nextToken
 }
 
 /*%define api.value.type variant*/
@@ -51,17 +55,17 @@
 	lake::Token * tokenValue;
 	lake::ASTNode * astNode;
 	lake::ProgramNode * programNode;
-	std::list<VarDeclNode *> * varDeclList;
-	std::list<DeclNode *> * declList;
+	lake::SeqBuilder<lake::VarDeclNode *> * varDeclList;
+	lake::SeqBuilder<lake::DeclNode *> * declList;
 	lake::VarDeclNode * varDeclNode;
 	lake::DeclNode * declNode;
 	lake::FnDeclNode * fnDecl;
 	lake::FormalDeclNode * formalDecl;
-	std::list<FormalDeclNode *> * formalsList;
+	lake::SeqBuilder<lake::FormalDeclNode *> * formalsList;
 	lake::FormalsListNode * formalsType;
 	lake::FnBodyNode * fnBody;
-	std::list<StmtNode *> * stmtList;
-	std::list<ExpNode *> * expList;
+	lake::SeqBuilder<lake::StmtNode *> * stmtList;
+	lake::SeqBuilder<lake::ExpNode *> * expList;
 	lake::TypeNode * typeNode;
 	lake::StmtNode * stmtNode;
 	lake::ExpNode * exp;
@@ -124,6 +128,9 @@
 %type <declList> declList
 %type <declNode> decl
 %type <varDeclList> varDeclList
+%type <varDeclList> fnDecls
+%type <varDeclList> blockDecls
+%type <varDeclList> elseDecls
 %type <varDeclNode> varDecl
 %type <typeNode> type
 %type <typeNode> primtype
@@ -158,7 +165,7 @@
 
 program : declList 
           {
-          $$ = new ProgramNode(new DeclListNode($1));
+          $$ = new (arena) ProgramNode(new (arena) DeclListNode($1->freeze()));
           *root = $$;
           }
 
@@ -169,144 +176,162 @@ declList : declList decl
            }
          | /* epsilon */ 
            {
-           $$ = new std::list<DeclNode *>();
+           $$ = new (arena) SeqBuilder<DeclNode *>(arena);
            }
 
 decl : varDecl { $$ = $1; }
      | fnDecl { $$ = $1; }
 
 varDeclList : varDeclList varDecl { $$ = $1; $$->push_back($2); }
-	    | /* epsilon */ { $$ = new std::list<VarDeclNode *>(); }
+	    | /* epsilon */ { $$ = new (arena) SeqBuilder<VarDeclNode *>(arena); }
 
 varDecl : type id SEMICOLON 
-          { $$ = new VarDeclNode($1, $2); }
+          { $$ = new (arena) VarDeclNode($1, $2); }
 
 fnDecl : type id formals fnBody 
-         { $$ = new FnDeclNode($1, $2, $3, $4); }
+         { $$ = new (arena) FnDeclNode($1, $2, $3, $4); }
 
 formals : LPAREN RPAREN 
-          { $$ = new FormalsListNode(new std::list<FormalDeclNode *>()); }
+          { $$ = new (arena) FormalsListNode(Seq<FormalDeclNode *>()); }
 	| LPAREN formalsList RPAREN 
-          { $$ = new FormalsListNode($2); }
+          { $$ = new (arena) FormalsListNode($2->freeze()); }
 
 formalsList : formalDecl 
               {
-              std::list<FormalDeclNode *> * list = new std::list<FormalDeclNode *>();
-              list->push_back($1);
-              $$ = list;
+              $$ = new (arena) SeqBuilder<FormalDeclNode *>(arena);
+              $$->push_back($1);
               }
-            | formalDecl COMMA formalsList 
+            | formalsList COMMA formalDecl 
               {
-              $3->push_front($1);
-              $$ = $3;
+              $1->push_back($3);
+              $$ = $1;
               }
 
-fnBody : LCURLY varDeclList stmtList RCURLY {
-         $$ = new FnBodyNode($1->_line, $1->_column, 
-		new VarDeclListNode($2), new StmtListNode($3));
+fnBody : LCURLY fnDecls stmtList RCURLY {
+         exps.leaveScope();
+         $$ = new (arena) FnBodyNode($1->_line, $1->_column, 
+		new (arena) VarDeclListNode($2->freeze()), 
+		new (arena) StmtListNode($3->freeze()));
        }
 
+/* Each body and block is a scope for the expressions built in it
+   (see ExpBuilder), opened once its declarations have been read */
+fnDecls : varDeclList { exps.enterScope(true); $$ = $1; }
+
+blockDecls : varDeclList 
+             { exps.enterScope($1->size() != 0); $$ = $1; }
+
+elseDecls : varDeclList 
+            {
+            exps.leaveScope();
+            exps.enterScope($1->size() != 0);
+            $$ = $1;
+            }
+
 formalDecl : type id 
-             { $$ = new FormalDeclNode($1, $2); }
+             { $$ = new (arena) FormalDeclNode($1, $2); }
 
 stmtList : /* epsilon */ 
-           { $$ = new std::list<StmtNode *>(); }
+           { $$ = new (arena) SeqBuilder<StmtNode *>(arena); }
          | stmtList stmt 
            { 
            $1->push_back($2);
            $$ = $1;
            }
 
-stmt : assignExp SEMICOLON { $$ = new AssignStmtNode($1); }
-     | loc CROSSCROSS SEMICOLON { $$ = new PostIncStmtNode($1); }
-     | loc DASHDASH SEMICOLON { $$ = new PostDecStmtNode($1); }
-     | READ loc SEMICOLON { $$ = new ReadStmtNode($2); }
-     | WRITE exp SEMICOLON { $$ = new WriteStmtNode($2); }
-     | IF LPAREN exp RPAREN LCURLY varDeclList stmtList RCURLY 
+stmt : assignExp SEMICOLON { $$ = new (arena) AssignStmtNode($1); }
+     | loc CROSSCROSS SEMICOLON { $$ = new (arena) PostIncStmtNode($1); }
+     | loc DASHDASH SEMICOLON { $$ = new (arena) PostDecStmtNode($1); }
+     | READ loc SEMICOLON { $$ = new (arena) ReadStmtNode($2); }
+     | WRITE exp SEMICOLON { $$ = new (arena) WriteStmtNode($2); }
+     | IF LPAREN exp RPAREN LCURLY blockDecls stmtList RCURLY 
         { 
-        $$ = new IfStmtNode($1->_line, $1->_column, $3, 
-		new VarDeclListNode($6),
-		new StmtListNode($7)
+        exps.leaveScope();
+        $$ = new (arena) IfStmtNode($1->_line, $1->_column, $3, 
+		new (arena) VarDeclListNode($6->freeze()),
+		new (arena) StmtListNode($7->freeze())
 	);
         }
-     | IF LPAREN exp RPAREN LCURLY varDeclList stmtList RCURLY ELSE LCURLY varDeclList stmtList RCURLY
+     | IF LPAREN exp RPAREN LCURLY blockDecls stmtList RCURLY ELSE LCURLY elseDecls stmtList RCURLY
         { 
-        $$ = new IfElseStmtNode(
+        exps.leaveScope();
+        $$ = new (arena) IfElseStmtNode(
                 $3, 
-                new VarDeclListNode($6), 
-                new StmtListNode($7), 
-                new VarDeclListNode($11),
-                new StmtListNode($12)
+                new (arena) VarDeclListNode($6->freeze()), 
+                new (arena) StmtListNode($7->freeze()), 
+                new (arena) VarDeclListNode($11->freeze()),
+                new (arena) StmtListNode($12->freeze())
 	); 
         }
-     | WHILE LPAREN exp RPAREN LCURLY varDeclList stmtList RCURLY
+     | WHILE LPAREN exp RPAREN LCURLY blockDecls stmtList RCURLY
        { 
-        $$ = new WhileStmtNode($1->_line, $1->_column, $3, 
-		new VarDeclListNode($6), new StmtListNode($7)); 
+        exps.leaveScope();
+        $$ = new (arena) WhileStmtNode($1->_line, $1->_column, $3, 
+		new (arena) VarDeclListNode($6->freeze()), 
+		new (arena) StmtListNode($7->freeze())); 
        }
      | RETURN exp SEMICOLON 
-	{ $$ = new ReturnStmtNode($1->_line, $1->_column, $2); }
+	{ $$ = new (arena) ReturnStmtNode($1->_line, $1->_column, $2); }
      | RETURN SEMICOLON 
-       { $$ = new ReturnStmtNode($1->_line, $1->_column, nullptr); }
-     | fncall SEMICOLON { $$ = new CallStmtNode($1); }
+       { $$ = new (arena) ReturnStmtNode($1->_line, $1->_column, nullptr); }
+     | fncall SEMICOLON { $$ = new (arena) CallStmtNode($1); }
 
 
 assignExp : loc ASSIGN exp 
-      { $$ = new AssignNode($2->_line, $2->_column, $1, $3); }
+      { $$ = new (arena) AssignNode($2->_line, $2->_column, $1, $3); }
 
 exp : assignExp
 	{ $$ = $1; }
     | exp CROSS exp 
-      { $$ = new PlusNode($2->_line, $2->_column, $1, $3); }
+      { $$ = exps.binary(PLUS_NODE, $2, $1, $3); }
     | exp DASH exp 
-      { $$ = new MinusNode($2->_line, $2->_column, $1, $3); }
+      { $$ = exps.binary(MINUS_NODE, $2, $1, $3); }
     | exp STAR exp 
-      { $$ = new TimesNode($2->_line, $2->_column, $1, $3); }
+      { $$ = exps.binary(TIMES_NODE, $2, $1, $3); }
     | exp SLASH exp 
-      { $$ = new DivideNode($2->_line, $2->_column, $1, $3); }
+      { $$ = exps.binary(DIVIDE_NODE, $2, $1, $3); }
     | NOT exp 
-      { $$ = new NotNode($1->_line, $1->_column, $2); }
+      { $$ = exps.notExp($1, $2); }
     | exp AND exp 
-      { $$ = new AndNode($2->_line, $2->_column, $1, $3); }
+      { $$ = exps.binary(AND_NODE, $2, $1, $3); }
     | exp OR exp 
-      { $$ = new OrNode($2->_line, $2->_column, $1, $3); }
+      { $$ = exps.binary(OR_NODE, $2, $1, $3); }
     | exp EQUALS exp 
-      { $$ = new EqualsNode($2->_line, $2->_column, $1, $3); }
+      { $$ = exps.binary(EQUALS_NODE, $2, $1, $3); }
     | exp NOTEQUALS exp 
-      { $$ = new NotEqualsNode($2->_line, $2->_column, $1, $3); }
+      { $$ = exps.binary(NOT_EQUALS_NODE, $2, $1, $3); }
     | exp LESS exp 
-      { $$ = new LessNode($2->_line, $2->_column, $1, $3); }
+      { $$ = exps.binary(LESS_NODE, $2, $1, $3); }
     | exp GREATER exp 
-      { $$ = new GreaterNode($2->_line, $2->_column, $1, $3); }
+      { $$ = exps.binary(GREATER_NODE, $2, $1, $3); }
     | exp LESSEQ exp 
-      { $$ = new LessEqNode($2->_line, $2->_column, $1, $3); }
+      { $$ = exps.binary(LESS_EQ_NODE, $2, $1, $3); }
     | exp GREATEREQ exp 
-      { $$ = new GreaterEqNode($2->_line, $2->_column, $1, $3); }
-    | DASH term { $$ = new UnaryMinusNode($2); }
+      { $$ = exps.binary(GREATER_EQ_NODE, $2, $1, $3); }
+    | DASH term { $$ = exps.unaryMinus($2); }
     | term { $$ = $1; }
 
 term : loc { $$ = $1; }
-     | INTLITERAL { $$ = new IntLitNode($1); }
-     | STRINGLITERAL { $$ = new StrLitNode($1); }
-     | TRUE { $$ = new TrueNode($1->_line, $1->_column); }
-     | FALSE { $$ = new FalseNode($1->_line, $1->_column); }
+     | INTLITERAL { $$ = exps.intLit($1); }
+     | STRINGLITERAL { $$ = exps.strLit($1); }
+     | TRUE { $$ = exps.trueLit($1); }
+     | FALSE { $$ = exps.falseLit($1); }
      | LPAREN exp RPAREN { $$ = $2; }
      | fncall { $$ = $1; }
 
 fncall : id LPAREN RPAREN 
         { 
-        $$ = new CallExpNode($1, new ExpListNode(new std::list<ExpNode *>()));
+        $$ = new (arena) CallExpNode($1, new (arena) ExpListNode(Seq<ExpNode *>()));
         }
         | id LPAREN actualList RPAREN 
         { 
-        $$ = new CallExpNode($1, new ExpListNode($3)); 
+        $$ = new (arena) CallExpNode($1, new (arena) ExpListNode($3->freeze())); 
         }
 
 actualList : exp 
         { 
-        std::list<ExpNode *> * list = new std::list<ExpNode *>();
-        list->push_back($1);
-        $$ = list;
+        $$ = new (arena) SeqBuilder<ExpNode *>(arena);
+        $$->push_back($1);
         }
         | actualList COMMA exp 
         {
@@ -320,18 +345,18 @@ type : primtype ptrdepth
 	$$->setPtrDepth($2);
 	}
 
-primtype : INT { $$ = new IntNode($1->_line, $1->_column); }
-     | BOOL { $$ = new BoolNode($1->_line, $1->_column); }
-     | VOID { $$ = new VoidNode($1->_line, $1->_column); }
+primtype : INT { $$ = new (arena) IntNode($1->_line, $1->_column); }
+     | BOOL { $$ = new (arena) BoolNode($1->_line, $1->_column); }
+     | VOID { $$ = new (arena) VoidNode($1->_line, $1->_column); }
 
 
 ptrdepth : DEREF ptrdepth { $$ = $2 + 1; }
 	| /* epsilon */ { $$ = 0; }
 
-loc : id { $$ = $1; }
-    | DEREF loc { $$ = new DerefNode($1->_line, $1->_column, $2); }
+loc : ID { $$ = exps.id($1); }
+    | DEREF loc { $$ = exps.deref($1, $2); }
 
-id : ID { $$ = new IdNode($1); }
+id : ID { $$ = new (arena) IdNode($1); }
 
 %%
 void
@@ -1,127 +1,134 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
-#include <fstream>
-#include "scanner.hpp"
-#include "symbol_table.hpp"
-#include "types.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+#include "batch.hpp"
+#include "driver.hpp"
+#include "server.hpp"
 
 using namespace lake;
 
 static void usageAndDie(){
-	std::cerr << "Usage: lakec <infile> <options>"
-	<< " [-t <tokensFile>]"
+	std::cerr << "Usage: lakec <infile>... <options>"
+	<< " [-t <tokensFile>] [--binary-tokens]"
 	<< " [-p <unparseFile>]"
 	<< " [-n <nameAnalysisFile>]"
 	<< " [-c]"
+	<< " [-j <workers>] [--lex-threads <n>]"
+	<< " [--scanner=flex|hand]"
+	<< " [--flat-ast] [--emit-ast <astFile>] [--load-ast <astFile>]"
+	<< " [--hash-cons]"
+	<< " [--time-passes[=json]] [--mem-report]"
+	<< " [--socket <path>] [--no-server]"
 	<< "\n"
+	<< "       lakec --serve [--socket <path>]\n"
+	<< "       lakec --stop-server [--socket <path>]\n"
+	<< "  Inputs may include @<file>, a file listing one input per line\n"
+	<< "  An input written by -t with --binary-tokens is read without"
+	<< " scanning\n"
+	<< "  With --load-ast, an AST file saved by --emit-ast from the same"
+	<< " input\n  is used instead of scanning and parsing\n"
 	;
 	exit(1);
 }
 
-static ProgramNode * parse(const char * inFile){
-	std::ifstream inStream(inFile);
-	if (!inStream.good()){
-		std::string msg = "Bad input stream ";
-		msg += inFile;
-		throw new InternalError(msg.c_str());
-	}
-
-	lake::Scanner scanner(&inStream);
-	ProgramNode * root = NULL;
-	lake::Parser parser(scanner, &root);
-	int errCode = parser.parse();
-	if (errCode != 0){ return NULL; }
-
-	return root;
-}
-
-static void writeTokenStream(const char * inPath, const char * outPath){
-	std::ifstream inStream(inPath);
-	if (!inStream.good()){
-		std::string msg = "Bad input stream";
-		msg += inPath;
-		throw new InternalError(msg.c_str());
-	}
-	if (outPath == nullptr){
-		std::string msg = "No tokens output file given";
-		throw new InternalError(msg.c_str());
-	}
-
-	Scanner scanner(&inStream);
-	if (strcmp(outPath, "--") == 0){
-		scanner.outputTokens(std::cout);
-	} else {
-		std::ofstream outStream(outPath);
-		if (!outStream.good()){
-			std::string msg = "Bad output file ";
-			msg += outPath;
-			throw new InternalError(msg.c_str());
-		}
-		scanner.outputTokens(outStream);
-		outStream.close();
-	}
-}
-
-static void unparse(ASTNode * astRoot, const char * outFile){
-	if (outFile == nullptr){
-		throw new InternalError("Null unparse file given");
-	}
-	if (strcmp(outFile, "--") == 0){
-		astRoot->unparse(std::cout, 0);
-	} else {
-		std::ofstream outStream(outFile);
-		astRoot->unparse(outStream, 0);
-		outStream.close();
-	}
-}
-
-int 
+int
 main( const int argc, const char **argv )
 {
 	if (argc == 0){
 		usageAndDie();
 	}
-	const char * inFile = NULL;
-	const char * tokensFile = NULL;
-	const char * unparseFile = NULL;
-	const char * nameAnalysisFile = NULL;
-	bool doTypeChecking = false;
-	const char * flattenFile = NULL;
-	const char * outputFile = NULL;
-	bool verbose = false;
+	std::vector<std::string> inFiles;
+	DriverOptions opts;
+	size_t workers = std::thread::hardware_concurrency();
 	bool useful = false;
-	int i = 1;
+	bool serve = false;
+	bool stop = false;
+	bool useServer = true;
+	std::string socketPath = defaultSocketPath();
 	for (int i = 1 ; i < argc ; i++){
-		if (argv[i][0] == '-'){
+		if (strcmp(argv[i], "--serve") == 0){
+			serve = true;
+		} else if (strcmp(argv[i], "--stop-server") == 0){
+			stop = true;
+		} else if (strcmp(argv[i], "--no-server") == 0){
+			useServer = false;
+		} else if (strcmp(argv[i], "--time-passes") == 0){
+			opts.timePasses = TABLE_REPORT;
+		} else if (strcmp(argv[i], "--time-passes=json") == 0){
+			opts.timePasses = JSON_REPORT;
+		} else if (strcmp(argv[i], "--mem-report") == 0){
+			opts.memReport = true;
+		} else if (strcmp(argv[i], "--scanner=flex") == 0){
+			opts.scanner = FLEX_BACKEND;
+		} else if (strcmp(argv[i], "--scanner=hand") == 0){
+			opts.scanner = HAND_BACKEND;
+		} else if (strcmp(argv[i], "--flat-ast") == 0){
+			opts.flatAST = true;
+		} else if (strcmp(argv[i], "--hash-cons") == 0){
+			opts.hashCons = true;
+		} else if (strcmp(argv[i], "--binary-tokens") == 0){
+			opts.binaryTokens = true;
+		} else if (strcmp(argv[i], "--lex-threads") == 0){
+			i++;
+			if (i >= argc){ usageAndDie(); }
+			opts.lexThreads = strtoul(argv[i], nullptr, 10);
+			if (opts.lexThreads == 0){ 
+				opts.lexThreads = std::thread::hardware_concurrency();
+			}
+		} else if (strcmp(argv[i], "--emit-ast") == 0){
+			i++;
+			if (i >= argc){ usageAndDie(); }
+			opts.emitASTFile = argv[i];
+			useful = true;
+		} else if (strcmp(argv[i], "--load-ast") == 0){
+			i++;
+			if (i >= argc){ usageAndDie(); }
+			opts.loadASTFile = argv[i];
+		} else if (strcmp(argv[i], "--socket") == 0){
+			i++;
+			if (i >= argc){ usageAndDie(); }
+			socketPath = argv[i];
+		} else if (argv[i][0] == '-'){
 			if (argv[i][1] == 't'){
 				i++;
-				tokensFile = argv[i];
+				opts.tokensFile = argv[i];
 				useful = true;
 			} else if (argv[i][1] == 'p'){
 				i++;
-				unparseFile = argv[i];
+				opts.unparseFile = argv[i];
 				useful = true;
 			} else if (argv[i][1] == 'n'){
 				i++;
-				nameAnalysisFile = argv[i];
+				opts.nameAnalysisFile = argv[i];
 				useful = true;
 			} else if (argv[i][1] == 'c'){
-				i++;
-				doTypeChecking = true;
+				opts.doTypeChecking = true;
 				useful = true;
-			} 
-		} else {
-			if (inFile == NULL){
-				inFile = argv[i];
-			} else {
-				std::cerr << "Only 1 input file allowed";
-				std::cerr << argv[i] << std::endl;
+			} else if (argv[i][1] == 'j'){
+				i++;
+				if (i >= argc){ usageAndDie(); }
+				workers = strtoul(argv[i], nullptr, 10);
+			}
+		} else if (argv[i][0] == '@'){
+			if (!readResponseFile(argv[i] + 1, inFiles)){
+				std::cerr << "Bad response file "
+					<< argv[i] + 1 << std::endl;
 				usageAndDie();
 			}
+		} else {
+			inFiles.push_back(argv[i]);
 		}
 	}
-	if (inFile == NULL){
+	if (serve){
+		return runServer(socketPath);
+	}
+	if (stop){
+		return stopServer(socketPath) ? 0 : 1;
+	}
+	if (inFiles.empty()){
 		usageAndDie();
 	}
 	if (!useful){
@@ -129,73 +136,43 @@ main( const int argc, const char **argv )
 		usageAndDie();
 	}
 
-	int retCode = 0;
-
-	if (tokensFile != NULL){
-		try {
-			writeTokenStream(inFile, tokensFile);
-		} catch (InternalError * e){
-			std::cerr << "Error: " << e->what() << std::endl;
+	if (inFiles.size() == 1){
+		//Outputs written to files would land relative to the
+		// server, so only stdout outputs are forwarded to it, and
+		// AST files are only read and written locally.
+		// The server scans serially, so a request for parallel
+		// scanning is served locally, and a memory report is made
+		// locally too, since it would count the server's
+		// allocations rather than this compile's.
+		bool remotable = useServer
+			&& opts.lexThreads <= 1
+			&& !opts.memReport
+			&& opts.emitASTFile == NULL
+			&& opts.loadASTFile == NULL
+			&& (opts.tokensFile == NULL 
+			    || strcmp(opts.tokensFile, "--") == 0)
+			&& (opts.unparseFile == NULL 
+			    || strcmp(opts.unparseFile, "--") == 0)
+			&& (opts.nameAnalysisFile == NULL 
+			    || strcmp(opts.nameAnalysisFile, "--") == 0);
+		int status = 0;
+		if (remotable && compileRemote(
+		    socketPath, inFiles[0].c_str(), opts, status)){
+			return status;
 		}
+		return compileFile(inFiles[0].c_str(), opts);
 	}
 
-	if (unparseFile != NULL){
-		try {
-			ASTNode * astRoot = parse(inFile);
-			if (astRoot == NULL){
-				std::cerr << "Parsing Error\n";
-				exit(1);
-			}
-			unparse(astRoot, unparseFile);
-		} catch (ToDoError * e){
-			std::cerr << "ToDo: " << e->what() << std::endl;
-			exit(1);
-		}
-	}
-	
-	if (nameAnalysisFile != NULL){
-		try {
-			ASTNode * astRoot = parse(inFile);
-			if (astRoot == NULL){
-				std::cerr << "Parsing Error\n";
-				exit(1);
-			}
-			SymbolTable * symTab = new SymbolTable();
-			bool nameAnalysisOk = astRoot->nameAnalysis(symTab);
-			if (nameAnalysisOk){
-				unparse(astRoot, nameAnalysisFile);
-			}
-		} catch (ToDoError * e){
-			std::cerr << "ToDo: " << e->what() << std::endl;
-			exit(1);
-		}
-	}
-	if (doTypeChecking){
-		try {
-			ASTNode * astRoot = parse(inFile);
-			if (astRoot == NULL){
-				std::cerr << "Parsing failed\n";
-				exit(1);
-			}
-			SymbolTable * symTab = new SymbolTable();
-			bool nameAnalysisOk = astRoot->nameAnalysis(symTab);
-			if (!nameAnalysisOk){
-				std::cerr << "Name analysis Failed\n";
-				exit(1);
-			}
-
-			TypeAnalysis * typeAnalysis = new TypeAnalysis();
-			static_cast<ProgramNode *>(astRoot)->typeAnalysis(typeAnalysis);
-			if (!typeAnalysis->passed()){
-				std::cerr << "Type checking failed\n";
-			}
-		} catch (ToDoError * e){
-			std::cerr << "ToDo: " << e->what() << std::endl;
-			exit(1);
-		} catch (InternalError * e){
-			std::cerr << "Compiler is Broken! " << e->what() << std::endl;
-			exit(1);
-		}
+	//Batch mode: the per-file outputs would all collide on the
+	// same path, so only type checking is allowed
+	if (opts.tokensFile != NULL
+	    || opts.unparseFile != NULL
+	    || opts.nameAnalysisFile != NULL
+	    || opts.emitASTFile != NULL
+	    || opts.loadASTFile != NULL){
+		std::cerr << "Only -c is allowed with multiple input files\n";
+		usageAndDie();
 	}
-	return retCode;
+	if (workers == 0){ workers = 1; }
+	return compileBatch(inFiles, opts, workers);
 }
@@ -0,0 +1,170 @@
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <sys/resource.h>
+#include "memstats.hpp"
+
+namespace lake{
+
+static thread_local MemStats * activeStats = nullptr;
+
+MemStats::MemStats(){
+	for (int slot = 0 ; slot < NUM_SLOTS ; slot++){
+		for (int cls = 0 ; cls < NUM_ALLOC_CLASSES ; cls++){
+			classCount[slot][cls] = 0;
+			classBytes[slot][cls] = 0;
+		}
+		arenaCount[slot] = 0;
+		arenaBytes[slot] = 0;
+		heapCount[slot] = 0;
+		heapBytes[slot] = 0;
+	}
+}
+
+MemStats::Scope::Scope(MemStats * stats) : previous(activeStats){
+	activeStats = stats;
+}
+
+MemStats::Scope::~Scope(){
+	activeStats = previous;
+}
+
+MemStats * MemStats::installed(){
+	return activeStats;
+}
+
+void MemStats::merge(const MemStats& other){
+	for (int slot = 0 ; slot < NUM_SLOTS ; slot++){
+		for (int cls = 0 ; cls < NUM_ALLOC_CLASSES ; cls++){
+			classCount[slot][cls] += other.classCount[slot][cls];
+			classBytes[slot][cls] += other.classBytes[slot][cls];
+		}
+		arenaCount[slot] += other.arenaCount[slot];
+		arenaBytes[slot] += other.arenaBytes[slot];
+		heapCount[slot] += other.heapCount[slot];
+		heapBytes[slot] += other.heapBytes[slot];
+	}
+}
+
+void MemStats::record(AllocClass cls, size_t bytes){
+	MemStats * stats = activeStats;
+	if (stats == nullptr){ return; }
+	int slot = PhaseTimer::current();
+	stats->classCount[slot][cls]++;
+	stats->classBytes[slot][cls] += bytes;
+}
+
+void MemStats::recordArenaBlock(size_t bytes){
+	MemStats * stats = activeStats;
+	if (stats == nullptr){ return; }
+	int slot = PhaseTimer::current();
+	stats->arenaCount[slot]++;
+	stats->arenaBytes[slot] += bytes;
+}
+
+void MemStats::recordHeap(size_t bytes){
+	MemStats * stats = activeStats;
+	if (stats == nullptr){ return; }
+	int slot = PhaseTimer::current();
+	stats->heapCount[slot]++;
+	stats->heapBytes[slot] += bytes;
+}
+
+size_t MemStats::peakRSSKiB(){
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0){ return 0; }
+	return static_cast<size_t>(usage.ru_maxrss);
+}
+
+const char * MemStats::className(AllocClass cls){
+	switch(cls){
+		case TOKEN_ALLOC: return "Token";
+		case AST_ALLOC: return "ASTNode";
+		case SYMBOL_ALLOC: return "SemSymbol";
+		case SCOPE_ALLOC: return "ScopeTable";
+		case VARTYPE_ALLOC: return "VarType";
+		case TUPLETYPE_ALLOC: return "TupleType";
+		case FNTYPE_ALLOC: return "FnType";
+		case NUM_ALLOC_CLASSES: break;
+	}
+	return "UNKNOWN CLASS";
+}
+
+const char * MemStats::slotName(int slot){
+	if (slot == NUM_PHASES){ return "other"; }
+	return PassTimings::phaseName(static_cast<Phase>(slot));
+}
+
+static void reportRow(std::ostream& out, const char * cls, 
+	const char * phase, size_t count, size_t bytes)
+{
+	out << std::left << std::setw(12) << cls 
+		<< std::setw(16) << phase << std::right
+		<< std::setw(12) << count 
+		<< std::setw(14) << bytes << "\n";
+}
+
+//The rows of one counter kept per slot, and their total
+static void reportSlots(std::ostream& out, const char * cls, 
+	const size_t * counts, const size_t * bytes, int slots, 
+	const char * (*slotName)(int))
+{
+	size_t countTotal = 0;
+	size_t bytesTotal = 0;
+	for (int slot = 0 ; slot < slots ; slot++){
+		if (counts[slot] == 0){ continue; }
+		reportRow(out, cls, slotName(slot), counts[slot], bytes[slot]);
+		countTotal += counts[slot];
+		bytesTotal += bytes[slot];
+	}
+	reportRow(out, cls, "total", countTotal, bytesTotal);
+}
+
+void MemStats::report(std::ostream& out, const char * input) const{
+	out << "===== Memory report: " << input << " =====\n";
+	out << std::left << std::setw(12) << "class" 
+		<< std::setw(16) << "phase" << std::right
+		<< std::setw(12) << "count" 
+		<< std::setw(14) << "bytes" << "\n";
+	for (int cls = 0 ; cls < NUM_ALLOC_CLASSES ; cls++){
+		size_t countTotal = 0;
+		size_t bytesTotal = 0;
+		const char * name = className(static_cast<AllocClass>(cls));
+		for (int slot = 0 ; slot < NUM_SLOTS ; slot++){
+			if (classCount[slot][cls] == 0){ continue; }
+			reportRow(out, name, slotName(slot), 
+				classCount[slot][cls], classBytes[slot][cls]);
+			countTotal += classCount[slot][cls];
+			bytesTotal += classBytes[slot][cls];
+		}
+		reportRow(out, name, "total", countTotal, bytesTotal);
+	}
+	reportSlots(out, "arena", arenaCount, arenaBytes, NUM_SLOTS, 
+		slotName);
+#ifdef LAKE_HEAP_STATS
+	reportSlots(out, "heap", heapCount, heapBytes, NUM_SLOTS, slotName);
+#endif
+	out << "peak RSS (whole process): " << peakRSSKiB() << " KiB\n";
+}
+
+} //End namespace lake
+
+#ifdef LAKE_HEAP_STATS
+//Count every heap allocation. These replace the global
+// operators, and only do bookkeeping while a MemStats is
+// installed on the calling thread.
+void * operator new(size_t size){
+	lake::MemStats::recordHeap(size);
+	void * ptr = malloc(size == 0 ? 1 : size);
+	if (ptr == nullptr){ throw std::bad_alloc(); }
+	return ptr;
+}
+
+void operator delete(void * ptr) noexcept{
+	free(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept{
+	free(ptr);
+}
+#endif
@@ -0,0 +1,86 @@
+#ifndef LAKE_MEMSTATS_HPP
+#define LAKE_MEMSTATS_HPP
+
+#include <cstddef>
+#include <ostream>
+#include "arena.hpp"
+#include "timing.hpp"
+
+namespace lake{
+
+//The front end object families that are counted separately
+enum AllocClass{
+	TOKEN_ALLOC, AST_ALLOC, SYMBOL_ALLOC, SCOPE_ALLOC, 
+	VARTYPE_ALLOC, TUPLETYPE_ALLOC, FNTYPE_ALLOC,
+	NUM_ALLOC_CLASSES
+};
+
+//Allocation counts for one compilation, broken down by object
+// family and by the phase that was running (see PhaseTimer).
+// The blocks arenas take from the heap are counted under "arena".
+// Builds made with HEAP_STATS=1 also replace the global operator
+// new and count every heap allocation under "heap", so containers
+// and strings show up there too; that costs every allocation a
+// check, so other builds leave it out. Counting only happens
+// while an instance is installed on the calling thread with
+// MemStats::Scope.
+class MemStats{
+public:
+	MemStats();
+	void report(std::ostream& out, const char * input) const;
+	//The peak resident set of the whole process so far, which in
+	// a batch covers every file compiled before
+	static size_t peakRSSKiB();
+	//Add in counts gathered separately, e.g. by a helper thread
+	void merge(const MemStats& other);
+	//The stats installed on the calling thread, if any
+	static MemStats * installed();
+
+	//Charge an allocation to the stats installed on this thread
+	static void record(AllocClass cls, size_t bytes);
+	static void recordArenaBlock(size_t bytes);
+	static void recordHeap(size_t bytes);
+
+	//Installs stats on the calling thread for its lifetime
+	class Scope{
+	public:
+		Scope(MemStats * stats);
+		~Scope();
+	private:
+		MemStats * previous;
+	};
+private:
+	static const int NUM_SLOTS = NUM_PHASES + 1;
+	static const char * className(AllocClass cls);
+	static const char * slotName(int slot);
+	size_t classCount[NUM_SLOTS][NUM_ALLOC_CLASSES];
+	size_t classBytes[NUM_SLOTS][NUM_ALLOC_CLASSES];
+	size_t arenaCount[NUM_SLOTS];
+	size_t arenaBytes[NUM_SLOTS];
+	size_t heapCount[NUM_SLOTS];
+	size_t heapBytes[NUM_SLOTS];
+};
+
+//Mix-in giving a class operator news that charge its instances
+// to an AllocClass, whether they are placed on the heap or in
+// an Arena
+template <AllocClass CLS>
+class MemCounted{
+public:
+	static void * operator new(size_t size){
+		MemStats::record(CLS, size);
+		return ::operator new(size);
+	}
+	static void * operator new(size_t size, Arena& arena){
+		MemStats::record(CLS, size);
+		return arena.allocate(size);
+	}
+	static void operator delete(void * ptr){
+		::operator delete(ptr);
+	}
+	static void operator delete(void *, Arena&){ }
+};
+
+} //End namespace lake
+
+#endif
@@ -32,7 +32,7 @@ bool ProgramNode::nameAnalysis(SymbolTable * symTab){
 
 bool VarDeclListNode::nameAnalysis(SymbolTable * symTab){
 	bool res = true;
-	for (auto elt : *myDecls){
+	for (auto elt : myDecls){
 		res = elt->nameAnalysis(symTab) && res;
 	}
 	return res;
@@ -96,7 +96,7 @@ bool WhileStmtNode::nameAnalysis(SymbolTable * symTab){
 
 bool DeclListNode::nameAnalysis(SymbolTable * symTab){
 	bool result = true;
-	for (auto decl : *myDecls){
+	for (auto decl : myDecls){
 		result = decl->nameAnalysis(symTab) && result;
 	}
 	return result;
@@ -104,7 +104,7 @@ bool DeclListNode::nameAnalysis(SymbolTable * symTab){
 
 bool StmtListNode::nameAnalysis(SymbolTable * symTab){
 	bool result = true;
-	for (auto elt : *myStmts){
+	for (auto elt : myStmts){
 		result = elt->nameAnalysis(symTab) && result;
 	}
 	return result;
@@ -128,7 +128,7 @@ static bool dataDecl(SymbolTable * symTab, DeclNode * decl, TypeNode * typeNode)
 		validType = false;
 	}
 
-	std::string varName = decl->getDeclaredName();
+	NameID varName = decl->getDeclaredNameID();
 	bool validName = !symTab->clash(varName);
 	if (!validName){ 
 		NameErr::multiDecl(decl->getLine(), decl->getCol()); 
@@ -136,7 +136,7 @@ static bool dataDecl(SymbolTable * symTab, DeclNode * decl, TypeNode * typeNode)
 
 	if (!validType || !validName){ return false; }
 
-	SemSymbol * sym = new SemSymbol(VAR, dataType, varName);
+	SemSymbol * sym = symTab->newSymbol(VAR, dataType, varName);
 	decl->getDeclaredID()->attachSymbol(sym);
 	symTab->insert(sym);
 	return true;
@@ -151,7 +151,7 @@ bool FormalDeclNode::nameAnalysis(SymbolTable * symTab){
 }
 
 bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
-	std::string fnName = this->getDeclaredName();
+	NameID fnName = this->getDeclaredNameID();
 	const DataType * retType = myType->getReturnType();
 	const VarType * retVarType = retType->asVar();
 	if (retVarType->getBaseType() == BaseType::VOID){
@@ -183,8 +183,8 @@ bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
 	//Make sure the fnSymbol is in the symbol table before 
 	// analyzing the body, to allow for recursive calls
 	if (validName && validFormals){
-		FnType * fnType = new FnType(formalsType, retType);
-		SemSymbol * fnSym = new SemSymbol(FN, fnType, fnName);
+		FnType * fnType = FnType::produce(formalsType, retType);
+		SemSymbol * fnSym = symTab->newSymbol(FN, fnType, fnName);
 		atFnScope->insert(fnSym);
 		getDeclaredID()->attachSymbol(fnSym);
 	}
@@ -197,7 +197,7 @@ bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
 
 bool FormalsListNode::nameAnalysis(SymbolTable * symTab){
 	bool result = true;
-	for (auto elt : *myFormals){
+	for (auto elt : myFormals){
 		result = elt->nameAnalysis(symTab) && result;
 	}
 	return result;
@@ -219,7 +219,7 @@ bool BinaryExpNode::nameAnalysis(SymbolTable * symTab){
 
 bool ExpListNode::nameAnalysis(SymbolTable * symTab){
 	bool result = true;
-	for (auto elt : *myExps){
+	for (auto elt : myExps){
 		result = elt->nameAnalysis(symTab) && result;
 	}
 	return result;
@@ -263,7 +263,6 @@ bool DerefNode::nameAnalysis(SymbolTable * symTab){
 }
 
 bool IdNode::nameAnalysis(SymbolTable* symTab){
-	std::string myName = this->getString();
 	SemSymbol * sym = symTab->find(myName);
 	if (sym == nullptr){
 		return NameErr::undecl(this->getLine(), getCol());
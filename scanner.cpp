@@ -1,3 +1,4 @@
+#include <cstring>
 #include <fstream>
 #include "scanner.hpp"
 
@@ -6,151 +7,196 @@ using namespace lake;
 using TokenKind = lake::Parser::token;
 using Lexeme = lake::Parser::semantic_type;
 
+int lake::Scanner::LexerInput(char * buf, int maxSize)
+{
+   if (srcPos == nullptr){
+	return yyFlexLexer::LexerInput(buf, maxSize);
+   }
+   //Copy straight from the mapped text into flex's buffer
+   size_t left = static_cast<size_t>(srcEnd - srcPos);
+   size_t count = static_cast<size_t>(maxSize);
+   if (left < count){ count = left; }
+   memcpy(buf, srcPos, count);
+   srcPos += count;
+   return static_cast<int>(count);
+}
+
+int lake::Scanner::replayToken(Lexeme * const lval)
+{
+   const ScannedToken& tok = replay->at(replayPos);
+   //The last entry is always END, which is handed out for good
+   if (replayPos + 1 < replay->size()){ replayPos++; }
+   if (tok.diagEnd > replayDiag){
+	const std::string& diags = replay->diagnostics();
+	Err::out().write(diags.data() + replayDiag, 
+		static_cast<std::streamsize>(tok.diagEnd - replayDiag));
+	Err::out().flush();
+	replayDiag = tok.diagEnd;
+   }
+   lval->tokenValue = tok.token;
+   return tok.tag;
+}
+
 void lake::Scanner::outputTokens( std::ostream& out )
 {
    Lexeme lexeme;
    int tokenTag;
+   //Tokens are written with plain newlines and flushed once at
+   // the end, rather than flushing the stream for every token
    while(true){
-   	tokenTag = this->yylex(&lexeme);
+   	tokenTag = this->nextToken(&lexeme);
 	switch (tokenTag){
 		case TokenKind::END:
-			out << "EOF" << std::endl;
+			out << "EOF\n";
+			out.flush();
 			return;
 		case TokenKind::BOOL:
-			out << "bool" << std::endl;
+			out << "bool\n";
 			break;
 		case TokenKind::INT:
-			out << "int" << std::endl;
+			out << "int\n";
 			break;
 		case TokenKind::VOID:
-			out << "void" << std::endl;
+			out << "void\n";
 			break;
 		case TokenKind::TRUE:
-			out << "true" << std::endl;
+			out << "true\n";
 			break;
 		case TokenKind::FALSE:
-			out << "false" << std::endl;
+			out << "false\n";
 			break;
 		case TokenKind::IF:
-			out << "if" << std::endl;
+			out << "if\n";
 			break;
 		case TokenKind::ELSE:
-			out << "else" << std::endl;
+			out << "else\n";
 			break;
 		case TokenKind::WHILE:
-			out << "while" << std::endl;
+			out << "while\n";
 			break;
 		case TokenKind::RETURN:
-			out << "return" << std::endl;
+			out << "return\n";
 			break;
 		case TokenKind::ID:
 			{
 			IDToken * tok = static_cast<IDToken *>(
 				lexeme.tokenValue);
-			out << "ID:" << tok->value() << std::endl;
+			out << "ID:" << tok->value() << "\n";
 			break;
 			}
 		case TokenKind::INTLITERAL:
 			{
 			IntLitToken * tok = static_cast<IntLitToken *>(
 				lexeme.tokenValue);
-			out << "INTLIT:" << tok->value() << std::endl;	
+			out << "INTLIT:" << tok->value() << "\n";	
 			break;
 			}
 		case TokenKind::STRINGLITERAL:
 			{
 			StringLitToken * tok = static_cast<StringLitToken *>(
 				lexeme.tokenValue);
-			out << "STRINGLIT:" << tok->value() << std::endl;	
+			out << "STRINGLIT:";
+			out.write(tok->text(), static_cast<std::streamsize>(tok->length()));
+			out << "\n";
 			break;
 			}
 		case TokenKind::LBRACE:
-			out << "[" << std::endl;
+			out << "[\n";
 			break;
 		case TokenKind::RBRACE:
-			out << "]" << std::endl;
+			out << "]\n";
 			break;
 		case TokenKind::LCURLY:
-			out << "{" << std::endl;
+			out << "{\n";
 			break;
 		case TokenKind::RCURLY:
-			out << "}" << std::endl;
+			out << "}\n";
 			break;
 		case TokenKind::LPAREN:
-			out << "(" << std::endl;
+			out << "(\n";
 			break;
 		case TokenKind::RPAREN:
-			out << ")" << std::endl;
+			out << ")\n";
 			break;
 		case TokenKind::SEMICOLON:
-			out << ";" << std::endl;
+			out << ";\n";
 			break;
 		case TokenKind::COMMA:
-			out << "," << std::endl;
+			out << ",\n";
 			break;
 		case TokenKind::WRITE:
-			out << "<<" << std::endl;
+			out << "<<\n";
 			break;
 		case TokenKind::READ:
-			out << ">>" << std::endl;
+			out << ">>\n";
 			break;
 		case TokenKind::CROSSCROSS:
-			out << "++" << std::endl;
+			out << "++\n";
 			break;
 		case TokenKind::DASHDASH:
-			out << "--" << std::endl;
+			out << "--\n";
 			break;
 		case TokenKind::CROSS:
-			out << "+" << std::endl;
+			out << "+\n";
 			break;
 		case TokenKind::DASH:
-			out << "-" << std::endl;
+			out << "-\n";
 			break;
 		case TokenKind::STAR:
-			out << "*" << std::endl;
+			out << "*\n";
 			break;
 		case TokenKind::SLASH:
-			out << "/" << std::endl;
+			out << "/\n";
 			break;
 		case TokenKind::NOT:
-			out << "!" << std::endl;
+			out << "!\n";
 			break;
 		case TokenKind::AND:
-			out << "&&" << std::endl;
+			out << "&&\n";
 			break;
 		case TokenKind::OR:
-			out << "||" << std::endl;
+			out << "||\n";
 			break;
 		case TokenKind::EQUALS:
-			out << "==" << std::endl;
+			out << "==\n";
 			break;
 		case TokenKind::NOTEQUALS:
-			out << "!=" << std::endl;
+			out << "!=\n";
 			break;
 		case TokenKind::LESS:
-			out << "<" << std::endl;
+			out << "<\n";
 			break;
 		case TokenKind::GREATER:
-			out << ">" << std::endl;
+			out << ">\n";
 			break;
 		case TokenKind::LESSEQ:
-			out << "<=" << std::endl;
+			out << "<=\n";
 			break;
 		case TokenKind::GREATEREQ:
-			out << ">=" << std::endl;
+			out << ">=\n";
 			break;
 		case TokenKind::ASSIGN:
-			out << "=" << std::endl;
+			out << "=\n";
 			break;
 		case TokenKind::DEREF:
-			out << "@" << std::endl;
+			out << "@\n";
 			break;
 		case TokenKind::REF:
-			out << "^" << std::endl;
+			out << "^\n";
 			break;
 		default:
-			out << "UNKNOWN TOKEN" << std::endl;
+			out << "UNKNOWN TOKEN\n";
 			break;
 	}
    }
 }
+
+size_t lake::Scanner::countTokens()
+{
+   Lexeme lexeme;
+   size_t count = 0;
+   while (this->nextToken(&lexeme) != TokenKind::END){
+	count++;
+   }
+   return count;
+}
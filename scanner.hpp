@@ -5,7 +5,12 @@
 #include <FlexLexer.h>
 #endif
 
+#include "arena.hpp"
 #include "grammar.hh"
+#include "hand_scanner.hpp"
+#include "source.hpp"
+#include "source_manager.hpp"
+#include "token_buffer.hpp"
 
 namespace lake{
 
@@ -16,8 +21,70 @@ public:
    {
 	lineNum = 1;
 	charNum = 1;
+	srcPos = nullptr;
+	srcEnd = nullptr;
+	replay = nullptr;
+	hand = nullptr;
+	sources = nullptr;
+   };
+
+   //Scan a source, reading straight from memory when the 
+   // source is in memory and from its stream otherwise. The
+   // hand-written backend needs the whole text in memory, so
+   // streamed sources always use flex.
+   Scanner(const SourceFile& src, ScannerBackend backend = FLEX_BACKEND)
+   : yyFlexLexer(src.stream())
+   {
+	lineNum = 1;
+	charNum = 1;
+	srcPos = nullptr;
+	srcEnd = nullptr;
+	replay = nullptr;
+	hand = nullptr;
+	sources = nullptr;
+	if (src.inMemory()){
+		srcPos = src.data();
+		srcEnd = src.data() + src.size();
+		if (backend == HAND_BACKEND){
+			hand = new HandScanner(srcPos, srcEnd, 1, tokenArena);
+		}
+	}
+   };
+
+   //Scan one piece of a larger in-memory source. The piece must
+   // start at the beginning of a line.
+   Scanner(const char * begin, const char * end, size_t firstLine,
+	ScannerBackend backend = FLEX_BACKEND)
+   : yyFlexLexer(nullptr)
+   {
+	lineNum = firstLine;
+	charNum = 1;
+	srcPos = begin;
+	srcEnd = end;
+	replay = nullptr;
+	hand = nullptr;
+	sources = nullptr;
+	if (backend == HAND_BACKEND){
+		hand = new HandScanner(begin, end, firstLine, tokenArena);
+	}
+   };
+
+   //Hand out the tokens of an already scanned buffer, reporting
+   // its diagnostics as the tokens they precede are reached
+   Scanner(const TokenBuffer& buffer) : yyFlexLexer(nullptr)
+   {
+	lineNum = 1;
+	charNum = 1;
+	srcPos = nullptr;
+	srcEnd = nullptr;
+	replay = &buffer;
+	replayPos = 0;
+	replayDiag = 0;
+	hand = nullptr;
+	sources = nullptr;
    };
    virtual ~Scanner() {
+	delete hand;
    };
 
    //get rid of override virtual function warning
@@ -27,13 +94,30 @@ public:
    virtual
    int yylex( lake::Parser::semantic_type * const lval);
 
-   void warn(int lineNumIn, int charNumIn, std::string msg){
-	std::cerr << lineNumIn << ":" << charNumIn 
+   //The next token for the parser, whether scanned or replayed
+   int nextToken( lake::Parser::semantic_type * const lval){
+	int tag;
+	if (hand != nullptr){ tag = hand->next(lval->tokenValue); }
+	else if (replay == nullptr){ tag = yylex(lval); }
+	else { tag = replayToken(lval); }
+	if (sources != nullptr && tag != Parser::token::END){
+		Token * token = lval->tokenValue;
+		sources->noteToken(token->_line, token->_column);
+	}
+	return tag;
+   }
+
+   //Note the position of every token handed out from now on, so
+   // that nodes built from them can be given locations
+   void noteLocations(SourceManager * sourcesIn){ sources = sourcesIn; }
+
+   static void warn(int lineNumIn, int charNumIn, std::string msg){
+	Err::out() << lineNumIn << ":" << charNumIn 
 		<< " ***WARNING*** " << msg << std::endl;
    }
 
-   void error(int lineNumIn, int charNumIn, std::string msg){
-	std::cerr << lineNumIn << ":" << charNumIn 
+   static void error(int lineNumIn, int charNumIn, std::string msg){
+	Err::out() << lineNumIn << ":" << charNumIn 
 		<< " ***ERROR*** " << msg << std::endl;
    }
 
@@ -45,19 +129,46 @@ public:
 	of copy-paste in the .l file.
    */
    int produceNoArgToken(int tagIn){
-        this->yylval->tokenValue = new NoArgToken(
+        this->yylval->tokenValue = new (tokenArena) NoArgToken(
 	  this->lineNum, this->charNum, tagIn);
         charNum += static_cast<size_t>(yyleng);
         return tagIn;
    }
 
+   /* Copy the current lexeme into the token arena, so that
+	it outlives flex's buffer */
+   const char * keepText(){
+	return tokenArena.copyString(yytext, static_cast<size_t>(yyleng));
+   }
+
    void outputTokens(std::ostream& outstream);
+   size_t countTokens();
+
+protected:
+   //Called by flex to refill its buffer
+   virtual int LexerInput(char * buf, int maxSize) override;
 
 private:
+   int replayToken( lake::Parser::semantic_type * const lval);
    /* yyval ptr */
    lake::Parser::semantic_type *yylval = nullptr;
    size_t lineNum;
    size_t charNum;
+   /* Every token this scanner produces lives here, and is 
+	released with the scanner: the parser copies out whatever
+	it needs while building the AST */
+   Arena tokenArena;
+   /* unread part of an in-memory source */
+   const char * srcPos;
+   const char * srcEnd;
+   /* buffer being replayed, if any, and the progress through it */
+   const TokenBuffer * replay;
+   size_t replayPos;
+   size_t replayDiag;
+   /* the hand-written backend, when it is used instead of flex */
+   HandScanner * hand;
+   /* where token positions are noted, if anywhere */
+   SourceManager * sources;
 };
 
 } /* end namespace */
@@ -0,0 +1,85 @@
+#ifndef LAKE_SEQ_HPP
+#define LAKE_SEQ_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "arena.hpp"
+
+namespace lake{
+
+//A fixed run of elements stored contiguously in an arena. A Seq
+// does not own its elements: they live as long as the arena that
+// holds them, and copying a Seq copies only the pointer and size.
+template <typename T>
+class Seq{
+public:
+	Seq() : myData(nullptr), mySize(0){ }
+	Seq(T * data, size_t size) : myData(data), mySize(size){ }
+	T * begin() const { return myData; }
+	T * end() const { return myData + mySize; }
+	size_t size() const { return mySize; }
+	bool empty() const { return mySize == 0; }
+	T& front() const { return myData[0]; }
+	T& back() const { return myData[mySize - 1]; }
+	T& operator[](size_t i) const { return myData[i]; }
+private:
+	T * myData;
+	size_t mySize;
+};
+
+//Collects the elements of a Seq while it is being built, e.g. as
+// the parser reduces a list production. The first INLINE elements
+// are kept in the builder itself; past that the elements move to
+// arena storage that doubles as it fills. freeze() hands back the
+// finished Seq, after which the builder must not be used again.
+// Only plain values such as node pointers may be collected, since
+// elements are moved with memcpy and never destroyed.
+template <typename T, size_t INLINE = 8>
+class SeqBuilder{
+	static_assert(std::is_trivially_copyable<T>::value,
+		"SeqBuilder elements are copied bytewise");
+public:
+	SeqBuilder(Arena& arenaIn)
+	: arena(arenaIn), data(inlineData), count(0), capacity(INLINE){ }
+	SeqBuilder(const SeqBuilder&) = delete;
+	SeqBuilder& operator=(const SeqBuilder&) = delete;
+
+	void push_back(const T& elt){
+		if (count == capacity){ grow(); }
+		data[count++] = elt;
+	}
+	size_t size() const { return count; }
+
+	//Elements still in the inline buffer are copied out to an
+	// exactly sized run; spilled elements stay where they are.
+	Seq<T> freeze(){
+		if (count == 0){ return Seq<T>(); }
+		if (data == inlineData){
+			T * frozen = allocate(count);
+			memcpy(frozen, inlineData, count * sizeof(T));
+			return Seq<T>(frozen, count);
+		}
+		return Seq<T>(data, count);
+	}
+private:
+	T * allocate(size_t n){
+		return static_cast<T *>(arena.allocate(n * sizeof(T), alignof(T)));
+	}
+	void grow(){
+		T * bigger = allocate(capacity * 2);
+		memcpy(bigger, data, count * sizeof(T));
+		data = bigger;
+		capacity *= 2;
+	}
+
+	Arena& arena;
+	T inlineData[INLINE];
+	T * data;
+	size_t count;
+	size_t capacity;
+};
+
+} //End namespace lake
+
+#endif
@@ -0,0 +1,492 @@
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "server.hpp"
+#include "err.hpp"
+
+// Wire protocol. Every message is a header line followed by a
+// fixed-length body.
+//
+//   request:  "<kind> <bodyLen> <outputs>\n" <body>
+//     kind    is "path" (body is a path the server opens),
+//             "source" (body is the program text), or "stop"
+//     outputs is a subset of "tpncTJMBHFS": the -t, -p and -n
+//             outputs are returned on the response's stdout
+//             channel, and c requests type checking, T or J 
+//             request a pass timing report as a table or as JSON,
+//             M requests a memory report, B makes -t a binary
+//             token dump, H selects the hand-written scanner, F
+//             works from a flattened tree, and S shares repeated
+//             expressions. "-" means none.
+//   response: "<status> <outLen> <errLen>\n" <out> <err>
+//
+// A request with a malformed header, or a body longer than
+// maxBodyLen, is answered with status 1 and an error instead. Only
+// processes of the server's own user are served, and a client only
+// talks to a server of its own user: a "path" request reads files
+// with the server's rights.
+
+namespace lake{
+
+//The longest request body the server accepts
+static const size_t maxBodyLen = 64 * 1024 * 1024;
+
+//How many connections are served at once; further clients wait in
+// the listen backlog until one of them finishes
+static const size_t maxConnections = 16;
+
+static bool writeAll(int fd, const char * buf, size_t len){
+	while (len > 0){
+		ssize_t n = write(fd, buf, len);
+		if (n < 0){
+			if (errno == EINTR){ continue; }
+			return false;
+		}
+		buf += n;
+		len -= static_cast<size_t>(n);
+	}
+	return true;
+}
+
+static bool readAll(int fd, std::string& buf, size_t len){
+	buf.resize(len);
+	size_t got = 0;
+	while (got < len){
+		ssize_t n = read(fd, &buf[got], len - got);
+		if (n < 0 && errno == EINTR){ continue; }
+		if (n <= 0){ return false; }
+		got += static_cast<size_t>(n);
+	}
+	return true;
+}
+
+static bool readLine(int fd, std::string& line){
+	line.clear();
+	char c;
+	while (true){
+		ssize_t n = read(fd, &c, 1);
+		if (n < 0 && errno == EINTR){ continue; }
+		if (n <= 0){ return false; }
+		if (c == '\n'){ return true; }
+		line += c;
+		if (line.size() > PATH_MAX){ return false; }
+	}
+}
+
+static bool fillAddress(const std::string& path, sockaddr_un& addr){
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path)){ return false; }
+	memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+	return true;
+}
+
+//True if the process at the other end of fd runs as this one's
+// user
+static bool peerIsUs(int fd){
+#ifdef SO_PEERCRED
+	ucred cred;
+	socklen_t len = sizeof(cred);
+	if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0){
+		return false;
+	}
+	return cred.uid == geteuid();
+#else
+	uid_t uid;
+	gid_t gid;
+	if (getpeereid(fd, &uid, &gid) != 0){ return false; }
+	return uid == geteuid();
+#endif
+}
+
+static int connectTo(const std::string& path){
+	sockaddr_un addr;
+	if (!fillAddress(path, addr)){ return -1; }
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0){ return -1; }
+	if (connect(fd, reinterpret_cast<sockaddr *>(&addr), 
+	    sizeof(addr)) != 0 || !peerIsUs(fd)){
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+//Where the default socket goes when there is no $XDG_RUNTIME_DIR
+static std::string fallbackSocketDir(){
+	return "/tmp/lakec-" + std::to_string(geteuid());
+}
+
+std::string defaultSocketPath(){
+	const char * env = getenv("LAKEC_SOCKET");
+	if (env != nullptr && env[0] != '\0'){ return env; }
+	const char * runtime = getenv("XDG_RUNTIME_DIR");
+	if (runtime != nullptr && runtime[0] != '\0'){
+		return std::string(runtime) + "/lakec.sock";
+	}
+	return fallbackSocketDir() + "/lakec.sock";
+}
+
+//Create dir for this user alone, or check that an existing one is
+// a directory of this user's that no one else can get into
+static bool makePrivateDir(const std::string& dir){
+	if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST){ 
+		return false; 
+	}
+	struct stat info;
+	return lstat(dir.c_str(), &info) == 0 
+		&& S_ISDIR(info.st_mode) 
+		&& info.st_uid == geteuid()
+		&& (info.st_mode & 077) == 0;
+}
+
+static std::string outputFlags(const DriverOptions& opts){
+	std::string flags = "";
+	if (opts.tokensFile != nullptr){ flags += "t"; }
+	if (opts.unparseFile != nullptr){ flags += "p"; }
+	if (opts.nameAnalysisFile != nullptr){ flags += "n"; }
+	if (opts.doTypeChecking){ flags += "c"; }
+	if (opts.timePasses == TABLE_REPORT){ flags += "T"; }
+	if (opts.timePasses == JSON_REPORT){ flags += "J"; }
+	if (opts.memReport){ flags += "M"; }
+	if (opts.binaryTokens){ flags += "B"; }
+	if (opts.scanner == HAND_BACKEND){ flags += "H"; }
+	if (opts.flatAST){ flags += "F"; }
+	if (opts.hashCons){ flags += "S"; }
+	if (flags.empty()){ flags = "-"; }
+	return flags;
+}
+
+//Send a response: its header, then both channels
+static void sendReply(int fd, int status, 
+	const std::string& outText, const std::string& errText)
+{
+	std::string reply = std::to_string(status) + " "
+		+ std::to_string(outText.size()) + " "
+		+ std::to_string(errText.size()) + "\n";
+	writeAll(fd, reply.c_str(), reply.size())
+		&& writeAll(fd, outText.c_str(), outText.size())
+		&& writeAll(fd, errText.c_str(), errText.size());
+}
+
+static std::string tooLongMessage(size_t bodyLen){
+	return "Request body of " + std::to_string(bodyLen) 
+		+ " bytes is over the server's limit of " 
+		+ std::to_string(maxBodyLen) + "\n";
+}
+
+//Serve one request on an accepted connection. Returns false if
+// the request asked the server to stop.
+static bool serveConnection(int fd){
+	std::string header;
+	if (!readLine(fd, header)){ return true; }
+	std::istringstream fields(header);
+	std::string kind;
+	size_t bodyLen = 0;
+	std::string flags;
+	fields >> kind >> bodyLen >> flags;
+	if (kind == "stop"){ return false; }
+
+	if (!fields){
+		sendReply(fd, 1, "", "Malformed request header\n");
+		return true;
+	}
+	if (bodyLen > maxBodyLen){
+		sendReply(fd, 1, "", tooLongMessage(bodyLen));
+		return true;
+	}
+	std::string body;
+	if (!readAll(fd, body, bodyLen)){ return true; }
+
+	std::ostringstream out;
+	std::ostringstream diags;
+	DriverOptions opts;
+	opts.stdoutStream = &out;
+	const char * toStdout = "--";
+	for (char flag : flags){
+		switch (flag){
+		case 't': opts.tokensFile = toStdout; break;
+		case 'p': opts.unparseFile = toStdout; break;
+		case 'n': opts.nameAnalysisFile = toStdout; break;
+		case 'c': opts.doTypeChecking = true; break;
+		case 'T': opts.timePasses = TABLE_REPORT; break;
+		case 'J': opts.timePasses = JSON_REPORT; break;
+		case 'M': opts.memReport = true; break;
+		case 'B': opts.binaryTokens = true; break;
+		case 'H': opts.scanner = HAND_BACKEND; break;
+		case 'F': opts.flatAST = true; break;
+		case 'S': opts.hashCons = true; break;
+		default: break;
+		}
+	}
+
+	int status = 1;
+	{
+		Err::Redirect capture(&diags);
+		if (kind == "path"){
+			status = compileFile(body.c_str(), opts);
+		} else if (kind == "source"){
+			SourceFile source;
+			source.useBuffer(body.data(), body.size());
+			status = compileSource(source, opts, "<source>");
+		} else {
+			Err::out() << "Bad request kind " << kind << "\n";
+		}
+	}
+
+	sendReply(fd, status, out.str(), diags.str());
+	return true;
+}
+
+//The socket this server bound, which is only removed while it is
+// still the same file
+static std::string servingPath;
+static dev_t servingDev;
+static ino_t servingIno;
+
+static void removeSocket(){
+	struct stat info;
+	if (lstat(servingPath.c_str(), &info) == 0 
+	    && info.st_dev == servingDev && info.st_ino == servingIno){
+		unlink(servingPath.c_str());
+	}
+}
+
+static void stopOnSignal(int sig){
+	removeSocket();
+	_exit(128 + sig);
+}
+
+//A connection being served on its own thread
+class Connection{
+public:
+	std::thread thread;
+	std::atomic<bool> done{false};
+};
+
+//Signalled, under finishedMutex, whenever a connection is done
+static std::mutex finishedMutex;
+static std::condition_variable finished;
+
+//Join the connections that are done, or all of them
+static void joinConnections(
+	std::vector<std::unique_ptr<Connection>>& connections, bool all)
+{
+	size_t kept = 0;
+	for (size_t i = 0; i < connections.size(); i++){
+		if (all || connections[i]->done){
+			connections[i]->thread.join();
+		} else {
+			std::swap(connections[kept++], connections[i]);
+		}
+	}
+	connections.resize(kept);
+}
+
+//Block until fewer than maxConnections connections are being served
+static void waitForRoom(
+	std::vector<std::unique_ptr<Connection>>& connections)
+{
+	joinConnections(connections, false);
+	if (connections.size() < maxConnections){ return; }
+	{
+		std::unique_lock<std::mutex> lock(finishedMutex);
+		finished.wait(lock, [&connections](){
+			for (const auto& connection : connections){
+				if (connection->done){ return true; }
+			}
+			return false;
+		});
+	}
+	joinConnections(connections, false);
+}
+
+int runServer(const std::string& socketPath){
+	sockaddr_un addr;
+	if (!fillAddress(socketPath, addr)){
+		std::cerr << "Socket path too long: " << socketPath << "\n";
+		return 1;
+	}
+	int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenFd < 0){
+		std::cerr << "socket: " << strerror(errno) << "\n";
+		return 1;
+	}
+	std::string fallbackDir = fallbackSocketDir() + "/";
+	if (socketPath.compare(0, fallbackDir.size(), fallbackDir) == 0
+	    && !makePrivateDir(fallbackSocketDir())){
+		std::cerr << "Cannot use " << fallbackSocketDir() 
+			<< ": it must be a directory only this user can use\n";
+		close(listenFd);
+		return 1;
+	}
+	//A stale socket of this user's from a server that died is safe
+	// to replace, but a live one, or any other file, is not
+	int probe = connectTo(socketPath);
+	if (probe >= 0){
+		close(probe);
+		std::cerr << "A server is already listening on " 
+			<< socketPath << "\n";
+		close(listenFd);
+		return 1;
+	}
+	struct stat info;
+	if (lstat(socketPath.c_str(), &info) == 0){
+		if (!S_ISSOCK(info.st_mode) || info.st_uid != geteuid()){
+			std::cerr << "Not replacing " << socketPath 
+				<< ": it is not a socket of this user's\n";
+			close(listenFd);
+			return 1;
+		}
+		unlink(socketPath.c_str());
+	}
+	//The socket is made unreachable for other users from the start
+	mode_t oldMask = umask(077);
+	bool bound = bind(listenFd, reinterpret_cast<sockaddr *>(&addr), 
+		sizeof(addr)) == 0;
+	umask(oldMask);
+	if (!bound || listen(listenFd, 64) != 0
+	    || lstat(socketPath.c_str(), &info) != 0){
+		std::cerr << "Cannot listen on " << socketPath 
+			<< ": " << strerror(errno) << "\n";
+		close(listenFd);
+		return 1;
+	}
+	servingPath = socketPath;
+	servingDev = info.st_dev;
+	servingIno = info.st_ino;
+	signal(SIGINT, stopOnSignal);
+	signal(SIGTERM, stopOnSignal);
+	signal(SIGPIPE, SIG_IGN);
+
+	//Each client is served on its own thread; diagnostics are
+	// captured per thread so concurrent requests never interleave.
+	// A stop request shuts the listening socket down, which wakes
+	// the accept loop below. Requests already being served are
+	// finished before the server returns. At most maxConnections
+	// are served at once.
+	std::vector<std::unique_ptr<Connection>> connections;
+	while (true){
+		int fd = accept(listenFd, nullptr, nullptr);
+		if (fd < 0){
+			if (errno == EINTR){ continue; }
+			break;
+		}
+		if (!peerIsUs(fd)){
+			close(fd);
+			continue;
+		}
+		waitForRoom(connections);
+		std::unique_ptr<Connection> connection(new Connection());
+		Connection * served = connection.get();
+		served->thread = std::thread([served, fd, listenFd](){
+			if (!serveConnection(fd)){
+				shutdown(listenFd, SHUT_RDWR);
+			}
+			close(fd);
+			{
+				std::lock_guard<std::mutex> lock(finishedMutex);
+				served->done = true;
+			}
+			finished.notify_one();
+		});
+		connections.push_back(std::move(connection));
+	}
+	joinConnections(connections, true);
+	close(listenFd);
+	removeSocket();
+	return 0;
+}
+
+bool compileRemote(
+	const std::string& socketPath, 
+	const char * inFile, 
+	const DriverOptions& opts,
+	int& status)
+{
+	//The server resolves paths against its own working directory.
+	// Anything but a regular file (a pipe, /dev/stdin) means
+	// something else to the server, so its text is sent instead.
+	// Such an input is only read once a server has answered, so
+	// that it is still there to compile locally otherwise.
+	struct stat info;
+	if (stat(inFile, &info) != 0){ return false; }
+	char resolved[PATH_MAX];
+	bool regular = S_ISREG(info.st_mode);
+	if (regular && realpath(inFile, resolved) == nullptr){ 
+		return false; 
+	}
+
+	int fd = connectTo(socketPath);
+	if (fd < 0){ return false; }
+
+	std::string kind = "path";
+	std::string body;
+	if (regular){
+		body = resolved;
+	} else {
+		kind = "source";
+		std::ifstream in(inFile, std::ios::in | std::ios::binary);
+		std::ostringstream text;
+		if (in.is_open()){ text << in.rdbuf(); }
+		if (!in.is_open() || in.bad()){
+			close(fd);
+			return false;
+		}
+		body = text.str();
+		//The server would refuse it, and the input is used up
+		if (body.size() > maxBodyLen){
+			close(fd);
+			std::cerr << tooLongMessage(body.size());
+			status = 1;
+			return true;
+		}
+	}
+
+	std::string request = kind + " " + std::to_string(body.size()) 
+		+ " " + outputFlags(opts) + "\n" + body;
+	std::string header;
+	bool ok = writeAll(fd, request.c_str(), request.size())
+		&& readLine(fd, header);
+	size_t outLen = 0;
+	size_t errLen = 0;
+	std::istringstream fields(header);
+	fields >> status >> outLen >> errLen;
+	std::string outText;
+	std::string errText;
+	ok = ok && fields 
+		&& readAll(fd, outText, outLen) 
+		&& readAll(fd, errText, errLen);
+	close(fd);
+	if (!ok){ return false; }
+
+	std::cout << outText;
+	std::cerr << errText;
+	return true;
+}
+
+bool stopServer(const std::string& socketPath){
+	int fd = connectTo(socketPath);
+	if (fd < 0){ return false; }
+	const char * request = "stop 0 -\n";
+	bool ok = writeAll(fd, request, strlen(request));
+	close(fd);
+	return ok;
+}
+
+} //End namespace lake
@@ -0,0 +1,38 @@
+#ifndef LAKE_SERVER_HPP
+#define LAKE_SERVER_HPP
+
+#include <string>
+#include "driver.hpp"
+
+namespace lake{
+
+//The socket used when none is given: $LAKEC_SOCKET if it is
+// set, or lakec.sock in $XDG_RUNTIME_DIR, or in a directory under
+// /tmp that only this user can use
+std::string defaultSocketPath();
+
+//Listen on a Unix domain socket and compile each request with
+// the in-process front end. The socket can only be used by this
+// user, and requests from other users are dropped. Runs until a
+// stop request arrives or the process is killed, and finishes the
+// requests in progress before returning. Returns the process exit
+// code.
+int runServer(const std::string& socketPath);
+
+//Forward a single-file compilation to a running server of this
+// user's. Returns false (without side effects) if there is none,
+// so the caller can fall back to compiling locally. On success,
+// the server's output and diagnostics have been written to stdout
+// and stderr and status holds the compilation's exit status.
+bool compileRemote(
+	const std::string& socketPath, 
+	const char * inFile, 
+	const DriverOptions& opts,
+	int& status);
+
+//Ask a running server to shut down
+bool stopServer(const std::string& socketPath);
+
+} //End namespace lake
+
+#endif
@@ -0,0 +1,144 @@
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "source.hpp"
+
+namespace lake{
+
+SourceFile::SourceFile()
+: myData(""), mySize(0), myMapped(false), myStream(nullptr), 
+  myStreamUsed(false), myDescriptorStream(&myDescriptorBuf){ }
+
+SourceFile::~SourceFile(){
+	release();
+}
+
+void SourceFile::release(){
+	if (myMapped){
+		munmap(const_cast<char *>(myData), mySize);
+		myMapped = false;
+	}
+	myData = "";
+	mySize = 0;
+	myBuffer.clear();
+	myDescriptorBuf.close();
+}
+
+bool SourceFile::open(const char * path){
+	release();
+	myStream = nullptr;
+
+	//The path is opened once, and what it is is asked of the open
+	// descriptor, so it cannot change in between. Only regular
+	// files are mapped.
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0){ return false; }
+	struct stat info;
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)){
+		size_t len = static_cast<size_t>(info.st_size);
+		if (len == 0){
+			::close(fd);
+			return true;
+		}
+		void * mem = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mem != MAP_FAILED){
+			::close(fd);
+			madvise(mem, len, MADV_SEQUENTIAL);
+			myData = static_cast<const char *>(mem);
+			mySize = len;
+			myMapped = true;
+			return true;
+		}
+	}
+
+	//Not mappable, so fall back to streaming from the same
+	// descriptor
+	myDescriptorBuf.attach(fd);
+	myDescriptorStream.clear();
+	myStream = &myDescriptorStream;
+	myStreamUsed = false;
+	return true;
+}
+
+void SourceFile::useStream(std::istream * in){
+	release();
+	myStream = in;
+	myStreamUsed = false;
+}
+
+void SourceFile::useBuffer(const char * data, size_t size){
+	release();
+	myStream = nullptr;
+	myData = data;
+	mySize = size;
+}
+
+void SourceFile::buffer(){
+	if (myStream == nullptr){ return; }
+	char chunk[1 << 16];
+	while (myStream->read(chunk, sizeof(chunk)) 
+	    || myStream->gcount() > 0){
+		myBuffer.append(chunk, static_cast<size_t>(myStream->gcount()));
+	}
+	myDescriptorBuf.close();
+	myStream = nullptr;
+	myData = myBuffer.data();
+	mySize = myBuffer.size();
+}
+
+void SourceFile::rewind(){
+	//The first scanner starts where the stream is, so pipes work
+	// as long as they are only scanned once
+	if (myStream == nullptr || !myStreamUsed){ 
+		myStreamUsed = true;
+		return; 
+	}
+	myStream->clear();
+	myStream->seekg(0);
+}
+
+size_t SourceFile::byteCount(){
+	if (myStream == nullptr){ return mySize; }
+	myStream->clear();
+	std::streampos start = myStream->tellg();
+	if (start < 0){
+		myStream->clear();
+		return 0;
+	}
+	myStream->seekg(0, std::ios_base::end);
+	std::streamoff size = myStream->tellg();
+	myStream->clear();
+	myStream->seekg(start);
+	return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+void SourceFile::DescriptorBuf::attach(int fdIn){
+	close();
+	fd = fdIn;
+	setg(chunk, chunk, chunk);
+}
+
+void SourceFile::DescriptorBuf::close(){
+	if (fd >= 0){
+		::close(fd);
+		fd = -1;
+	}
+	setg(chunk, chunk, chunk);
+}
+
+SourceFile::DescriptorBuf::int_type 
+SourceFile::DescriptorBuf::underflow(){
+	if (gptr() < egptr()){ return traits_type::to_int_type(*gptr()); }
+	if (fd < 0){ return traits_type::eof(); }
+	ssize_t got;
+	do {
+		got = read(fd, chunk, sizeof(chunk));
+	} while (got < 0 && errno == EINTR);
+	if (got <= 0){ return traits_type::eof(); }
+	setg(chunk, chunk, chunk + got);
+	return traits_type::to_int_type(*gptr());
+}
+
+} //End namespace lake
@@ -0,0 +1,71 @@
+#ifndef LAKE_SOURCE_HPP
+#define LAKE_SOURCE_HPP
+
+#include <cstddef>
+#include <istream>
+#include <streambuf>
+#include <string>
+
+namespace lake{
+
+//The text of one compilation's input. Regular files are mapped
+// into memory so the scanner can read them in place. Anything that
+// cannot be mapped (stdin, pipes, sockets) is streamed through an
+// istream instead, as are caller-provided streams. A stream can
+// only be read once, so a source that is scanned more than once
+// must be buffered first. A source can also wrap a buffer the
+// caller owns.
+class SourceFile{
+public:
+	SourceFile();
+	~SourceFile();
+	//Open a path, mapping it if possible. Returns false if the
+	// path cannot be read at all.
+	bool open(const char * path);
+	void useStream(std::istream * in);
+	void useBuffer(const char * data, size_t size);
+
+	//True if the whole text is available through data()/size()
+	bool inMemory() const { return myStream == nullptr; }
+	const char * data() const { return myData; }
+	size_t size() const { return mySize; }
+
+	//The stream for sources that are not in memory
+	std::istream * stream() const { return myStream; }
+	//Read a streamed source into memory, so that it can be
+	// scanned more than once. Call before the first scan.
+	void buffer();
+	//Call before creating each scanner, so that every scanner
+	// after the first starts from the beginning again
+	void rewind();
+	//The input size in bytes, or 0 if it cannot be known
+	size_t byteCount();
+private:
+	//Reads a descriptor that open() could not map
+	class DescriptorBuf : public std::streambuf{
+	public:
+		DescriptorBuf() : fd(-1){ }
+		~DescriptorBuf(){ close(); }
+		void attach(int fdIn);
+		void close();
+	protected:
+		int_type underflow() override;
+	private:
+		int fd;
+		char chunk[1 << 16];
+	};
+
+	void release();
+	const char * myData;
+	size_t mySize;
+	bool myMapped;
+	std::istream * myStream;
+	bool myStreamUsed;
+	std::string myBuffer;
+	DescriptorBuf myDescriptorBuf;
+	std::istream myDescriptorStream;
+};
+
+} //End namespace lake
+
+#endif
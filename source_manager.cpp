@@ -0,0 +1,72 @@
+#include <algorithm>
+#include "err.hpp"
+#include "source_manager.hpp"
+
+namespace lake{
+
+static thread_local SourceManager * activeSources = nullptr;
+
+//Line 0 holds only NO_LOC, so real locations start at 1
+SourceManager::SourceManager()
+: lineStarts(1, NO_LOC), lastLine(0), widest(0){ }
+
+void SourceManager::noteLine(size_t line, size_t col){
+	if (line < lastLine){
+		throw new InternalError("Tokens noted out of order");
+	}
+	//Lines without tokens still get one location, so that no two
+	// lines start at the same place
+	uint64_t next = lineStarts[lastLine];
+	for (size_t skipped = lastLine + 1 ; skipped <= line ; skipped++){
+		next += widest + 1;
+		widest = 0;
+		if (next > UINT32_MAX){
+			throw new InternalError("Input too large for 32-bit locations");
+		}
+		lineStarts.push_back(static_cast<SourceLoc>(next));
+	}
+	lastLine = line;
+	widest = col;
+}
+
+void SourceManager::loadLines(const SourceLoc * starts, size_t count){
+	if (count == 0 || starts[0] != NO_LOC){
+		throw new InternalError("Line table does not start at line 0");
+	}
+	lineStarts.assign(starts, starts + count);
+	lastLine = SIZE_MAX;
+	widest = 0;
+}
+
+size_t SourceManager::line(SourceLoc loc) const{
+	if (loc == NO_LOC){ return 0; }
+	auto after = std::upper_bound(lineStarts.begin(), lineStarts.end(), loc);
+	return static_cast<size_t>(after - lineStarts.begin()) - 1;
+}
+
+size_t SourceManager::col(SourceLoc loc) const{
+	if (loc == NO_LOC){ return 0; }
+	return loc - lineStarts[line(loc)] + 1;
+}
+
+SourceManager::Scope::Scope(SourceManager * sources)
+: previous(activeSources){
+	activeSources = sources;
+}
+
+SourceManager::Scope::~Scope(){
+	activeSources = previous;
+}
+
+SourceManager * SourceManager::installed(){
+	return activeSources;
+}
+
+SourceManager& SourceManager::current(){
+	if (activeSources == nullptr){
+		throw new InternalError("No SourceManager installed");
+	}
+	return *activeSources;
+}
+
+} //End namespace lake
@@ -0,0 +1,89 @@
+#ifndef LAKE_SOURCE_MANAGER_HPP
+#define LAKE_SOURCE_MANAGER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "err.hpp"
+
+namespace lake{
+
+//A position in one compilation's input, packed into 32 bits. The
+// line and column are only worked out again when they are needed,
+// e.g. to print a diagnostic.
+typedef uint32_t SourceLoc;
+
+//The location of nodes that have no position of their own
+const SourceLoc NO_LOC = 0;
+
+//Hands out SourceLocs for the positions of one compilation. Each
+// line owns a run of locations, one per column up to the furthest
+// column a token starts at, and the table of where each run
+// starts maps a location back to its line with a binary search.
+// Runs are laid out as the scanner's tokens reach the parser, so
+// every token must be noted, in order, before a position on its
+// line is encoded. Nodes find the manager through the one
+// installed on the calling thread with SourceManager::Scope.
+class SourceManager{
+public:
+	SourceManager();
+
+	//Record the position of a token handed to the parser
+	void noteToken(size_t line, size_t col){
+		if (line == lastLine){
+			if (col > widest){ widest = col; }
+			return;
+		}
+		noteLine(line, col);
+	}
+
+	//The location of a position at or before a noted token on
+	// the same line. Line 0 means no position. Throws if no
+	// token has been noted on the line.
+	SourceLoc encode(size_t line, size_t col) const{
+		if (line == 0){ return NO_LOC; }
+		if (line >= lineStarts.size()){
+			throw new InternalError("Location on a line with no tokens");
+		}
+		return lineStarts[line] + static_cast<SourceLoc>(col - 1);
+	}
+
+	//Where an encoded location is; both are 0 for NO_LOC
+	size_t line(SourceLoc loc) const;
+	size_t col(SourceLoc loc) const;
+
+	//Where each line's locations start, indexed by line number
+	const std::vector<SourceLoc>& getLineStarts() const { 
+		return lineStarts; 
+	}
+	//Take the lines of another compilation, saved from its
+	// getLineStarts(), so that its locations decode the same way
+	// here. No more tokens may be noted afterwards.
+	void loadLines(const SourceLoc * starts, size_t count);
+
+	//The manager installed on the calling thread, if any
+	static SourceManager * installed();
+	//The same, for callers that cannot go on without one: throws
+	// if no manager is installed
+	static SourceManager& current();
+
+	//Installs a manager on the calling thread for its lifetime
+	class Scope{
+	public:
+		Scope(SourceManager * sources);
+		~Scope();
+	private:
+		SourceManager * previous;
+	};
+private:
+	void noteLine(size_t line, size_t col);
+
+	//lineStarts[n] is the first location on line n
+	std::vector<SourceLoc> lineStarts;
+	size_t lastLine;
+	size_t widest;
+};
+
+} //End namespace lake
+
+#endif
@@ -3,60 +3,103 @@
 #include "types.hpp"
 namespace lake{
 
-SymbolTable::SymbolTable(){
-	scopeTableChain = new std::list<ScopeTable *>();
+SymbolTable::SymbolTable(Arena& symbolsIn) 
+: depth(0), symbols(symbolsIn){ }
+
+SymbolTable::~SymbolTable(){
+	for (ScopeTable * scope : scopes){ delete scope; }
 }
 
 ScopeTable * SymbolTable::enterScope(){
-	ScopeTable * newScope = new ScopeTable();
-	scopeTableChain->push_front(newScope);
-	return newScope;
+	if (depth == scopes.size()){
+		scopes.push_back(new ScopeTable(this, depth));
+	}
+	return scopes[depth++];
 }
 
 void SymbolTable::leaveScope(){
-	if (scopeTableChain->empty()){
+	if (depth == 0){
 		throw new InternalError("Attempt to pop"
 			"empty symbol table");
 	}
-	scopeTableChain->pop_front();
+	//Every scope inside this one is already closed, so each name
+	// it declared has its binding for this scope on top
+	ScopeTable * scope = scopes[--depth];
+	for (NameID name : scope->declared){
+		bindings[name].pop_back();
+	}
+	scope->declared.clear();
 }
 
 ScopeTable * SymbolTable::getCurrentScope(){
-	return scopeTableChain->front();
+	return scopes[depth - 1];
 }
 
 
-bool SymbolTable::clash(std::string varName){
+SemSymbol * SymbolTable::newSymbol(
+	SymbolKind kind, const DataType * type, NameID name)
+{
+	return new (symbols) SemSymbol(kind, type, name);
+}
+
+bool SymbolTable::clash(NameID varName){
 	bool hasClash = getCurrentScope()->clash(varName);
 	return hasClash;
 }
 
-SemSymbol * SymbolTable::find(std::string varName){
-	for (ScopeTable * scope : *scopeTableChain){
-		SemSymbol * sym = scope->lookup(varName);
-		if (sym != nullptr) { return sym; }
+SemSymbol * SymbolTable::find(NameID varName){
+	auto found = bindings.find(varName);
+	if (found == bindings.end() || found->second.empty()){ 
+		return nullptr; 
 	}
-	return nullptr;
+	return found->second.back().symbol;
 }
 
 bool SymbolTable::insert(SemSymbol * symbol){
-	return scopeTableChain->front()->insert(symbol);
+	return getCurrentScope()->insert(symbol);
 }
 
-ScopeTable::ScopeTable(){
-	symbols = new HashMap<std::string, SemSymbol *>();
+SemSymbol * SymbolTable::lookupIn(NameID name, size_t depth){
+	auto found = bindings.find(name);
+	if (found == bindings.end()){ return nullptr; }
+	const std::vector<Binding>& stack = found->second;
+	for (size_t i = stack.size() ; i > 0 ; i--){
+		if (stack[i - 1].depth < depth){ break; }
+		if (stack[i - 1].depth == depth){ return stack[i - 1].symbol; }
+	}
+	return nullptr;
 }
 
+bool SymbolTable::bind(SemSymbol * symbol, size_t depth){
+	NameID name = symbol->getNameID();
+	if (lookupIn(name, depth) != nullptr){ return false; }
+	std::vector<Binding>& stack = bindings[name];
+	//A scope other than the innermost can still be declared in
+	// (a function's name goes in the scope around its body), so
+	// the binding goes below those of any scopes inside
+	size_t pos = stack.size();
+	while (pos > 0 && stack[pos - 1].depth > depth){ pos--; }
+	Binding binding;
+	binding.symbol = symbol;
+	binding.depth = depth;
+	stack.insert(stack.begin() + static_cast<ptrdiff_t>(pos), binding);
+	scopes[depth]->declared.push_back(name);
+	return true;
+}
+
+ScopeTable::ScopeTable(SymbolTable * tableIn, size_t depthIn)
+: table(tableIn), depth(depthIn){ }
+
 std::string ScopeTable::toString(){
 	std::string result = "";
-	for (auto entry : *symbols){
-		result += entry.second->toString();
+	for (NameID name : declared){
+		result += lookup(name)->toString();
 		result += "\n";
 	}
 	return result;
 }
 
-bool ScopeTable::clash(std::string varName){
+bool ScopeTable::clash(NameID varName){
 	SemSymbol * found = lookup(varName);
 	if (found != nullptr){
 		return true;
@@ -64,22 +107,12 @@ bool ScopeTable::clash(std::string varName){
 	return false;
 }
 
-SemSymbol * ScopeTable::lookup(std::string name){
-	auto found = symbols->find(name);
-	if (found == symbols->end()){
-		return NULL;
-	}
-	return found->second;
+SemSymbol * ScopeTable::lookup(NameID name){
+	return table->lookupIn(name, depth);
 }
 
 bool ScopeTable::insert(SemSymbol * symbol){
-	std::string symName = symbol->getName();
-	bool alreadyInScope = (this->lookup(symName) != NULL);
-	if (alreadyInScope){
-		return false;
-	}
-	this->symbols->insert(std::make_pair(symName, symbol));
-	return true;
+	return table->bind(symbol, depth);
 }
 
 std::string SemSymbol::getTypeString(){
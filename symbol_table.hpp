@@ -2,8 +2,10 @@
 #define LAKE_SYMBOL_TABLE_HPP
 #include <string>
 #include <unordered_map>
-#include <list>
+#include <vector>
 #include "types.hpp"
+#include "interner.hpp"
+#include "memstats.hpp"
 
 //Use an alias template so that we can use
 // "HashMap" and it means "std::unordered_map"
@@ -22,14 +24,15 @@ enum SymbolKind {
 // variable, function, etc. Semantic symbols 
 // exist for the lifetime of a scope in the 
 // symbol table. 
-class SemSymbol {
+class SemSymbol : public MemCounted<SYMBOL_ALLOC> {
 public:
-	SemSymbol(SymbolKind kindIn, const DataType * typeIn, std::string nameIn) 
+	SemSymbol(SymbolKind kindIn, const DataType * typeIn, NameID nameIn) 
 	: myKind(kindIn), myType(typeIn), myName(nameIn){
 	}
 	virtual std::string getTypeString();
 	virtual std::string toString();
-	std::string getName() const { return myName; }
+	const std::string& getName() const { return Interner::name(myName); }
+	NameID getNameID() const { return myName; }
 	SymbolKind getKind() { return myKind; }
 	const DataType * getType() { return myType; }
 	static std::string kindToString(SymbolKind symKind) { 
@@ -42,37 +45,81 @@ public:
 private:
 	SymbolKind myKind;
 	const DataType * myType;
-	std::string myName;
+	NameID myName;
 };
 
+class SymbolTable;
+
 //A single scope. The symbol table is broken down into a 
-// chain of scope tables, and each scope table holds 
-// semantic symbols for a single scope. For example,
+// chain of scope tables, and each scope table stands for 
+// the semantic symbols of a single scope. For example,
 // the globals scope will be represented by a ScopeTable,
 // and the contents of each function can be represented by
-// a ScopeTable.
-class ScopeTable {
+// a ScopeTable. The symbols themselves are bound in the
+// SymbolTable's single map; a ScopeTable only records which
+// names it declared, so that leaving it unbinds exactly those.
+class ScopeTable : public MemCounted<SCOPE_ALLOC> {
 	public:
-		ScopeTable();
-		SemSymbol * lookup(std::string name);
+		ScopeTable(SymbolTable * tableIn, size_t depthIn);
+		SemSymbol * lookup(NameID name);
 		bool insert(SemSymbol * symbol);
-		bool clash(std::string name);
+		bool clash(NameID name);
 		std::string toString();
 	private:
-		HashMap<std::string, SemSymbol *> * symbols;
+		friend class SymbolTable;
+		SymbolTable * table;
+		//How many scopes enclose this one
+		size_t depth;
+		//The names declared here, in order: the undo log that
+		// leaveScope replays
+		std::vector<NameID> declared;
 };
 
+//The symbols of every open scope, in one map from each name to
+// its shadow stack: the declarations of that name in the open
+// scopes, innermost last. Finding the symbol a name refers to is
+// one hash lookup however deeply scopes are nested.
+//
+//Scope storage is recycled: a closed ScopeTable is kept to be
+// reopened at the same depth, and a name's stack stays in the map
+// when it empties, each keeping its capacity. Once the table has
+// seen its deepest nesting and all of its names, entering and
+// leaving scopes allocates nothing.
 class SymbolTable{
 	public:
-		SymbolTable();
+		//Symbols are placed in symbolsIn, which should be the arena
+		// of the tree they are attached to, so that they go away
+		// with it
+		SymbolTable(Arena& symbolsIn);
+		~SymbolTable();
+		SymbolTable(const SymbolTable&) = delete;
+		SymbolTable& operator=(const SymbolTable&) = delete;
 		ScopeTable * enterScope();
 		void leaveScope();
 		ScopeTable * getCurrentScope();
 		bool insert(SemSymbol * symbol);
-		SemSymbol * find(std::string varName);
-		bool clash(std::string name);
+		SemSymbol * find(NameID varName);
+		bool clash(NameID name);
+		SemSymbol * newSymbol(
+			SymbolKind kind, const DataType * type, NameID name);
 	private:
-		std::list<ScopeTable *> * scopeTableChain;
+		friend class ScopeTable;
+		class Binding{
+		public:
+			SemSymbol * symbol;
+			size_t depth;
+		};
+		//The symbol declared for name in the open scope at depth
+		SemSymbol * lookupIn(NameID name, size_t depth);
+		//Declare symbol in the open scope at depth, unless its name
+		// is already declared there
+		bool bind(SemSymbol * symbol, size_t depth);
+		HashMap<NameID, std::vector<Binding>> bindings;
+		//Every scope made so far, outermost first. The first
+		// depth of them are open.
+		std::vector<ScopeTable *> scopes;
+		size_t depth;
+		Arena& symbols;
 };
 
 	
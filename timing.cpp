@@ -0,0 +1,154 @@
+#include <ctime>
+#include <iomanip>
+#include "timing.hpp"
+
+namespace lake{
+
+PassTimings::PassTimings()
+: input("<input>"), inputBytes(0), tokens(0), astNodes(0){
+	for (int i = 0 ; i < NUM_PHASES ; i++){
+		wallSecs[i] = 0;
+		cpuSecs[i] = 0;
+	}
+}
+
+void PassTimings::add(Phase phase, double wallIn, double cpuIn){
+	wallSecs[phase] += wallIn;
+	cpuSecs[phase] += cpuIn;
+}
+
+void PassTimings::discount(Phase phase, double wallIn, double cpuIn){
+	wallSecs[phase] = wallSecs[phase] > wallIn ? wallSecs[phase] - wallIn : 0;
+	cpuSecs[phase] = cpuSecs[phase] > cpuIn ? cpuSecs[phase] - cpuIn : 0;
+}
+
+const char * PassTimings::phaseName(Phase phase){
+	switch(phase){
+		case SCAN_PHASE: return "scan";
+		case PARSE_PHASE: return "parse";
+		case NAME_PHASE: return "name analysis";
+		case TYPE_PHASE: return "type analysis";
+		case UNPARSE_PHASE: return "unparse";
+		case NUM_PHASES: break;
+	}
+	return "UNKNOWN PHASE";
+}
+
+void PassTimings::report(std::ostream& out, ReportFormat format) const{
+	if (format == TABLE_REPORT){ reportTable(out); }
+	if (format == JSON_REPORT){ reportJSON(out); }
+}
+
+static double rate(size_t count, double secs){
+	if (secs <= 0){ return 0; }
+	return static_cast<double>(count) / secs;
+}
+
+void PassTimings::reportTable(std::ostream& out) const{
+	out << "===== Pass timings: " << input << " =====\n";
+	out << std::left << std::setw(16) << "phase" << std::right
+		<< std::setw(12) << "wall (ms)"
+		<< std::setw(12) << "cpu (ms)" << "   throughput\n";
+	double wallTotal = 0;
+	double cpuTotal = 0;
+	out << std::fixed << std::setprecision(3);
+	for (int i = 0 ; i < NUM_PHASES ; i++){
+		Phase phase = static_cast<Phase>(i);
+		wallTotal += wallSecs[i];
+		cpuTotal += cpuSecs[i];
+		out << std::left << std::setw(16) << phaseName(phase) 
+			<< std::right
+			<< std::setw(12) << wallSecs[i] * 1000
+			<< std::setw(12) << cpuSecs[i] * 1000 << "   ";
+		if (phase == SCAN_PHASE){
+			out << std::setprecision(1)
+				<< rate(inputBytes, wallSecs[i]) / 1e6 << " MB/s, "
+				<< rate(tokens, wallSecs[i]) / 1e6 << " Mtokens/s"
+				<< std::setprecision(3);
+		} else if (phase == NAME_PHASE || phase == TYPE_PHASE){
+			out << std::setprecision(1)
+				<< rate(astNodes, wallSecs[i]) / 1e6 << " Mnodes/s"
+				<< std::setprecision(3);
+		}
+		out << "\n";
+	}
+	out << std::left << std::setw(16) << "total" << std::right
+		<< std::setw(12) << wallTotal * 1000
+		<< std::setw(12) << cpuTotal * 1000 << "\n";
+	out << inputBytes << " bytes, " << tokens << " tokens, "
+		<< astNodes << " AST nodes\n";
+	out.unsetf(std::ios_base::floatfield);
+	out << std::setprecision(6);
+}
+
+//Quote str as a JSON string. Control bytes other than newline,
+// which input paths may hold, are written as \u00XX escapes.
+static void jsonString(std::ostream& out, const std::string& str){
+	static const char hexDigits[] = "0123456789abcdef";
+	out << '"';
+	for (char c : str){
+		unsigned char byte = static_cast<unsigned char>(c);
+		if (c == '"' || c == '\\'){ out << '\\' << c; }
+		else if (c == '\n'){ out << "\\n"; }
+		else if (byte < 0x20){
+			out << "\\u00" << hexDigits[byte >> 4] 
+				<< hexDigits[byte & 0xf];
+		}
+		else { out << c; }
+	}
+	out << '"';
+}
+
+void PassTimings::reportJSON(std::ostream& out) const{
+	out << "{\"input\": ";
+	jsonString(out, input);
+	out << ", \"bytes\": " << inputBytes 
+		<< ", \"tokens\": " << tokens
+		<< ", \"ast_nodes\": " << astNodes
+		<< ", \"phases\": [";
+	for (int i = 0 ; i < NUM_PHASES ; i++){
+		Phase phase = static_cast<Phase>(i);
+		if (i > 0){ out << ", "; }
+		out << "{\"name\": ";
+		jsonString(out, phaseName(phase));
+		out << ", \"wall_s\": " << wallSecs[i]
+			<< ", \"cpu_s\": " << cpuSecs[i];
+		if (phase == SCAN_PHASE){
+			out << ", \"bytes_per_s\": " << rate(inputBytes, wallSecs[i])
+				<< ", \"tokens_per_s\": " << rate(tokens, wallSecs[i]);
+		} else if (phase == NAME_PHASE || phase == TYPE_PHASE){
+			out << ", \"nodes_per_s\": " << rate(astNodes, wallSecs[i]);
+		}
+		out << "}";
+	}
+	out << "]}\n";
+}
+
+static thread_local int currentPhase = NUM_PHASES;
+
+int PhaseTimer::current(){ return currentPhase; }
+
+PhaseTimer::PhaseTimer(PassTimings * timingsIn, Phase phaseIn)
+: timings(timingsIn), phase(phaseIn), outerPhase(currentPhase), cpuStart(0){
+	currentPhase = phase;
+	if (timings == nullptr){ return; }
+	wallStart = std::chrono::steady_clock::now();
+	cpuStart = threadCPUTime();
+}
+
+PhaseTimer::~PhaseTimer(){
+	currentPhase = outerPhase;
+	if (timings == nullptr){ return; }
+	std::chrono::duration<double> wallSecs = 
+		std::chrono::steady_clock::now() - wallStart;
+	timings->add(phase, wallSecs.count(), threadCPUTime() - cpuStart);
+}
+
+double PhaseTimer::threadCPUTime(){
+	timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return static_cast<double>(now.tv_sec) 
+		+ static_cast<double>(now.tv_nsec) / 1e9;
+}
+
+} //End namespace lake
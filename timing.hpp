@@ -0,0 +1,67 @@
+#ifndef LAKE_TIMING_HPP
+#define LAKE_TIMING_HPP
+
+#include <chrono>
+#include <ostream>
+#include <string>
+
+namespace lake{
+
+enum ReportFormat{
+	NO_REPORT, TABLE_REPORT, JSON_REPORT
+};
+
+enum Phase{
+	SCAN_PHASE, PARSE_PHASE, NAME_PHASE, TYPE_PHASE, UNPARSE_PHASE,
+	NUM_PHASES
+};
+
+//Wall and CPU time spent in each front end phase of one
+// compilation, along with the sizes needed to turn those times
+// into throughput figures. CPU time is per-thread, so the numbers
+// stay meaningful when files are compiled concurrently.
+class PassTimings{
+public:
+	PassTimings();
+	void add(Phase phase, double wallSecs, double cpuSecs);
+	//Remove time that was double-counted, never going below 0
+	void discount(Phase phase, double wallSecs, double cpuSecs);
+	double wall(Phase phase) const { return wallSecs[phase]; }
+	double cpu(Phase phase) const { return cpuSecs[phase]; }
+	void report(std::ostream& out, ReportFormat format) const;
+	static const char * phaseName(Phase phase);
+
+	std::string input;
+	size_t inputBytes;
+	size_t tokens;
+	size_t astNodes;
+private:
+	void reportTable(std::ostream& out) const;
+	void reportJSON(std::ostream& out) const;
+	double wallSecs[NUM_PHASES];
+	double cpuSecs[NUM_PHASES];
+};
+
+//Times the enclosing block and charges it to a phase. A null
+// timings pointer disables the timing, but the calling thread is
+// still marked as being in the phase (see current()) so that other
+// reports can attribute work to it.
+class PhaseTimer{
+public:
+	PhaseTimer(PassTimings * timingsIn, Phase phaseIn);
+	~PhaseTimer();
+	static double threadCPUTime();
+	//The phase the calling thread is in, or NUM_PHASES outside
+	// of any timed block
+	static int current();
+private:
+	PassTimings * timings;
+	Phase phase;
+	int outerPhase;
+	std::chrono::steady_clock::time_point wallStart;
+	double cpuStart;
+};
+
+} //End namespace lake
+
+#endif
@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include "interner.hpp"
+#include "memstats.hpp"
+#include "scanner.hpp"
+#include "token_buffer.hpp"
+
+namespace lake{
+
+//Pieces smaller than this are not worth a thread of their own
+static const size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+//What one scanner produced for its piece of the source
+class ChunkResult{
+public:
+	const char * begin = nullptr;
+	const char * end = nullptr;
+	size_t firstLine = 1;
+	std::vector<ScannedToken> tokens;
+	std::string diags;
+	double cpuSecs = 0;
+	MemStats stats;
+	//The names this piece's tokens were interned as, which are
+	// moved to the compilation's table once every piece is done
+	Interner names;
+};
+
+TokenBuffer::TokenBuffer(){ }
+
+TokenBuffer::~TokenBuffer(){
+	for (Scanner * scanner : scanners){
+		delete scanner;
+	}
+}
+
+//Run a scanner to the end of its input, keeping its diagnostics
+// alongside the tokens they were reported before
+static void scanAll(Scanner& scanner, ChunkResult& result){
+	std::ostringstream diagStream;
+	{
+		//On the single-chunk path this runs on the caller's
+		// thread, whose own redirection must survive it
+		Err::Redirect capture(&diagStream);
+		Parser::semantic_type lval;
+		while (true){
+			lval.tokenValue = nullptr;
+			int tag = scanner.nextToken(&lval);
+			ScannedToken tok;
+			tok.tag = tag;
+			tok.token = lval.tokenValue;
+			tok.diagEnd = static_cast<size_t>(diagStream.tellp());
+			result.tokens.push_back(tok);
+			if (tag == Parser::token::END){ break; }
+		}
+	}
+	result.diags = diagStream.str();
+}
+
+//Split [begin, end) into up to count pieces, each ending just
+// after a newline (or at the end of the text)
+static std::vector<ChunkResult> splitLines(
+	const char * begin, const char * end, size_t count)
+{
+	std::vector<ChunkResult> chunks;
+	size_t total = static_cast<size_t>(end - begin);
+	const char * pos = begin;
+	for (size_t i = 1 ; i <= count && pos < end ; i++){
+		const char * cut = begin + total / count * i;
+		if (i == count || cut >= end){
+			cut = end;
+		} else if (cut < pos){
+			cut = pos;
+		}
+		if (cut < end){
+			const void * newline = memchr(cut, '\n',
+				static_cast<size_t>(end - cut));
+			cut = newline == nullptr ? end
+				: static_cast<const char *>(newline) + 1;
+		}
+		ChunkResult chunk;
+		chunk.begin = pos;
+		chunk.end = cut;
+		chunks.push_back(std::move(chunk));
+		pos = cut;
+	}
+	return chunks;
+}
+
+void TokenBuffer::scan(
+	SourceFile& src, size_t threads, 
+	ScannerBackend backend, PassTimings * timings)
+{
+	src.rewind();
+	std::vector<ChunkResult> chunks;
+	if (src.inMemory()){
+		size_t count = std::max<size_t>(1, threads);
+		count = std::min(count, src.size() / MIN_CHUNK_BYTES);
+		chunks = splitLines(src.data(), src.data() + src.size(),
+			std::max<size_t>(1, count));
+	}
+
+	if (chunks.size() <= 1){
+		Scanner * scanner = new Scanner(src, backend);
+		scanners.push_back(scanner);
+		ChunkResult whole;
+		scanAll(*scanner, whole);
+		tokens = std::move(whole.tokens);
+		diags = std::move(whole.diags);
+		return;
+	}
+
+	//Each piece needs the number of the line it starts on, and
+	// counting newlines is far cheaper than scanning, so that is
+	// done first in a separate round
+	std::vector<std::thread> pool;
+	for (ChunkResult& chunk : chunks){
+		pool.emplace_back([&chunk](){
+			chunk.firstLine = static_cast<size_t>(
+				std::count(chunk.begin, chunk.end, '\n'));
+		});
+	}
+	for (std::thread& thread : pool){ thread.join(); }
+	pool.clear();
+	size_t line = 1;
+	for (ChunkResult& chunk : chunks){
+		size_t newlines = chunk.firstLine;
+		chunk.firstLine = line;
+		line += newlines;
+	}
+
+	for (ChunkResult& chunk : chunks){
+		scanners.push_back(
+			new Scanner(chunk.begin, chunk.end, chunk.firstLine, backend));
+	}
+	bool counting = MemStats::installed() != nullptr;
+	for (size_t i = 0 ; i < chunks.size() ; i++){
+		Scanner * scanner = scanners[i];
+		ChunkResult * chunk = &chunks[i];
+		pool.emplace_back([scanner, chunk, counting](){
+			MemStats::Scope memScope(counting ? &chunk->stats : nullptr);
+			Interner::Scope namesScope(&chunk->names);
+			PhaseTimer phase(nullptr, SCAN_PHASE);
+			double cpuStart = PhaseTimer::threadCPUTime();
+			scanAll(*scanner, *chunk);
+			chunk->cpuSecs = PhaseTimer::threadCPUTime() - cpuStart;
+		});
+	}
+	for (std::thread& thread : pool){ thread.join(); }
+
+	//Stitch the pieces together, keeping only the last END
+	size_t total = 0;
+	for (ChunkResult& chunk : chunks){ total += chunk.tokens.size(); }
+	tokens.reserve(total - chunks.size() + 1);
+	std::vector<NameID> renames;
+	for (size_t i = 0 ; i < chunks.size() ; i++){
+		ChunkResult& chunk = chunks[i];
+		renames.clear();
+		for (NameID id = 0 ; id < chunk.names.count() ; id++){
+			const std::string& name = chunk.names.text(id);
+			renames.push_back(Interner::intern(name.data(), name.size()));
+		}
+		size_t diagBase = diags.size();
+		bool last = i + 1 == chunks.size();
+		for (ScannedToken tok : chunk.tokens){
+			if (tok.tag == Parser::token::END && !last){ break; }
+			if (tok.tag == Parser::token::ID){
+				IDToken * id = static_cast<IDToken *>(tok.token);
+				id->rename(renames[id->id()]);
+			}
+			tok.diagEnd += diagBase;
+			tokens.push_back(tok);
+		}
+		diags += chunk.diags;
+		if (counting){ MemStats::installed()->merge(chunk.stats); }
+		if (timings != nullptr){
+			timings->add(SCAN_PHASE, 0, chunk.cpuSecs);
+		}
+	}
+}
+
+using TokenKind = Parser::token;
+
+//"LAKETOK" and a format version
+static const char DUMP_MAGIC[8] = {'L','A','K','E','T','O','K','\x01'};
+//Reads back differently if the byte order does not match
+static const uint32_t DUMP_BYTE_ORDER = 0x01020304;
+
+static void putWord(std::ostream& out, uint32_t word){
+	out.write(reinterpret_cast<const char *>(&word), sizeof(word));
+}
+
+static void putText(std::ostream& out, const char * text, size_t len){
+	putWord(out, static_cast<uint32_t>(len));
+	out.write(text, static_cast<std::streamsize>(len));
+}
+
+//Reads the parts of a dump in order, failing on truncation
+class DumpReader{
+public:
+	DumpReader(const char * data, size_t size) 
+	: pos(data), end(data + size){ }
+	bool word(uint32_t& word){
+		if (static_cast<size_t>(end - pos) < sizeof(word)){ 
+			return false; 
+		}
+		memcpy(&word, pos, sizeof(word));
+		pos += sizeof(word);
+		return true;
+	}
+	bool text(const char *& text, uint32_t& len){
+		if (!word(len)){ return false; }
+		if (static_cast<size_t>(end - pos) < len){ return false; }
+		text = pos;
+		pos += len;
+		return true;
+	}
+	bool skip(size_t count){
+		if (static_cast<size_t>(end - pos) < count){ return false; }
+		pos += count;
+		return true;
+	}
+	bool atEnd() const { return pos == end; }
+	size_t left() const { return static_cast<size_t>(end - pos); }
+private:
+	const char * pos;
+	const char * end;
+};
+
+void TokenBuffer::write(std::ostream& out) const{
+	//Give every distinct text one entry in the string table
+	std::vector<std::string> strings;
+	std::unordered_map<std::string, uint32_t> stringIndex;
+	std::vector<uint32_t> payloads(tokens.size(), 0);
+	for (size_t i = 0 ; i < tokens.size() ; i++){
+		const ScannedToken& tok = tokens[i];
+		std::string text;
+		if (tok.tag == TokenKind::ID){
+			text = static_cast<IDToken *>(tok.token)->value();
+		} else if (tok.tag == TokenKind::STRINGLITERAL){
+			text = static_cast<StringLitToken *>(tok.token)->value();
+		} else if (tok.tag == TokenKind::INTLITERAL){
+			payloads[i] = static_cast<uint32_t>(
+				static_cast<IntLitToken *>(tok.token)->value());
+			continue;
+		} else {
+			continue;
+		}
+		auto found = stringIndex.find(text);
+		if (found == stringIndex.end()){
+			uint32_t idx = static_cast<uint32_t>(strings.size());
+			found = stringIndex.emplace(text, idx).first;
+			strings.push_back(text);
+		}
+		payloads[i] = found->second;
+	}
+
+	//Only tokens that had diagnostics reported before them get
+	// a diagnostics record
+	uint32_t diagCount = 0;
+	size_t diagPos = 0;
+	for (const ScannedToken& tok : tokens){
+		if (tok.diagEnd > diagPos){ diagCount++; }
+		diagPos = tok.diagEnd;
+	}
+
+	out.write(DUMP_MAGIC, sizeof(DUMP_MAGIC));
+	putWord(out, DUMP_BYTE_ORDER);
+	putWord(out, static_cast<uint32_t>(strings.size()));
+	putWord(out, static_cast<uint32_t>(tokens.size()));
+	putWord(out, diagCount);
+	for (const std::string& text : strings){
+		putText(out, text.data(), text.size());
+	}
+	for (size_t i = 0 ; i < tokens.size() ; i++){
+		const ScannedToken& tok = tokens[i];
+		putWord(out, static_cast<uint32_t>(tok.tag));
+		putWord(out, tok.token == nullptr ? 0 
+			: static_cast<uint32_t>(tok.token->_line));
+		putWord(out, tok.token == nullptr ? 0 
+			: static_cast<uint32_t>(tok.token->_column));
+		putWord(out, payloads[i]);
+	}
+	diagPos = 0;
+	for (size_t i = 0 ; i < tokens.size() ; i++){
+		size_t diagEnd = tokens[i].diagEnd;
+		if (diagEnd <= diagPos){ continue; }
+		putWord(out, static_cast<uint32_t>(i));
+		putText(out, diags.data() + diagPos, diagEnd - diagPos);
+		diagPos = diagEnd;
+	}
+	out.flush();
+}
+
+bool TokenBuffer::isDump(const char * data, size_t size){
+	return size >= sizeof(DUMP_MAGIC) 
+		&& memcmp(data, DUMP_MAGIC, sizeof(DUMP_MAGIC)) == 0;
+}
+
+bool TokenBuffer::load(const char * data, size_t size){
+	if (!isDump(data, size)){ return false; }
+	DumpReader reader(data, size);
+	reader.skip(sizeof(DUMP_MAGIC));
+	uint32_t byteOrder, stringCount, tokenCount, diagCount;
+	if (!reader.word(byteOrder) || byteOrder != DUMP_BYTE_ORDER
+	    || !reader.word(stringCount)
+	    || !reader.word(tokenCount) || tokenCount == 0
+	    || !reader.word(diagCount)){
+		return false;
+	}
+	//Every string takes at least its length word and every token
+	// four words, so counts the rest of the dump cannot hold are
+	// refused before anything is sized by them
+	size_t minBytes = static_cast<size_t>(stringCount) * 4 
+		+ static_cast<size_t>(tokenCount) * 16;
+	if (minBytes > reader.left()){ return false; }
+
+	//IDs are interned again and string literal texts are copied, 
+	// so the tokens do not depend on the dump staying mapped
+	std::vector<const char *> texts(stringCount);
+	std::vector<uint32_t> lengths(stringCount);
+	for (uint32_t i = 0 ; i < stringCount ; i++){
+		if (!reader.text(texts[i], lengths[i])){ return false; }
+	}
+
+	tokens.reserve(tokenCount);
+	for (uint32_t i = 0 ; i < tokenCount ; i++){
+		uint32_t tag, line, col, payload;
+		if (!reader.word(tag) || !reader.word(line)
+		    || !reader.word(col) || !reader.word(payload)){
+			return false;
+		}
+		ScannedToken tok;
+		tok.tag = static_cast<int>(tag);
+		tok.diagEnd = 0;
+		if (tok.tag == TokenKind::END){
+			tok.token = nullptr;
+		} else if (tok.tag == TokenKind::ID 
+		    || tok.tag == TokenKind::STRINGLITERAL){
+			if (payload >= stringCount){ return false; }
+			if (tok.tag == TokenKind::ID){
+				tok.token = new (loadArena) IDToken(line, col, 
+					Interner::intern(texts[payload], lengths[payload]));
+			} else {
+				tok.token = new (loadArena) StringLitToken(line, col, 
+					loadArena.copyString(texts[payload], lengths[payload]),
+					lengths[payload]);
+			}
+		} else if (tok.tag == TokenKind::INTLITERAL){
+			tok.token = new (loadArena) IntLitToken(line, col, 
+				static_cast<int>(payload));
+		} else {
+			tok.token = new (loadArena) NoArgToken(line, col, tok.tag);
+		}
+		tokens.push_back(tok);
+	}
+	if (tokens.back().tag != TokenKind::END){ return false; }
+
+	size_t lastToken = 0;
+	for (uint32_t i = 0 ; i < diagCount ; i++){
+		uint32_t tokenIdx, len;
+		const char * text;
+		if (!reader.word(tokenIdx) || !reader.text(text, len)
+		    || tokenIdx >= tokenCount || tokenIdx < lastToken){
+			return false;
+		}
+		diags.append(text, len);
+		tokens[tokenIdx].diagEnd = diags.size();
+		lastToken = tokenIdx;
+	}
+	//Every token covers at least the diagnostics before it
+	for (size_t i = 1 ; i < tokens.size() ; i++){
+		tokens[i].diagEnd = std::max(tokens[i].diagEnd, 
+			tokens[i - 1].diagEnd);
+	}
+	return reader.atEnd();
+}
+
+} //End namespace lake
@@ -0,0 +1,77 @@
+#ifndef LAKE_TOKEN_BUFFER_HPP
+#define LAKE_TOKEN_BUFFER_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "arena.hpp"
+#include "hand_scanner.hpp"
+#include "source.hpp"
+#include "timing.hpp"
+#include "tokens.hpp"
+
+namespace lake{
+
+class Scanner;
+
+//One token of a buffered token stream. diagEnd is the offset in
+// the buffer's diagnostics just past anything the scanner reported
+// up to and including this token.
+class ScannedToken{
+public:
+	int tag;
+	Token * token;
+	size_t diagEnd;
+};
+
+//A whole file's tokens, scanned ahead of parsing. No Lake token
+// spans a newline (strings may not contain one, and comments end
+// at one), so a large in-memory source is split at line boundaries
+// and each piece is scanned on its own thread. The pieces are then
+// stitched back into a single stream, with line numbers and
+// diagnostics exactly as a single scanner would have produced them.
+// The tokens live in the buffer's scanners, so they are released
+// with the buffer.
+//
+//A buffer can also be saved as a binary token dump and loaded 
+// back later without scanning. A dump holds a header, a table of
+// the distinct identifier and string literal texts, one fixed-size
+// record (kind, line, column, payload) per token and the scanner's
+// diagnostics. A record's payload is a string table index for IDs
+// and string literals, the value for integer literals, and 0
+// otherwise. Dumps use the byte order of the machine that wrote
+// them, and a dump from a different byte order is rejected.
+class TokenBuffer{
+public:
+	TokenBuffer();
+	~TokenBuffer();
+	//Scan the whole source with the given backend, using up to
+	// the given number of threads. CPU time spent by helper
+	// threads is charged to SCAN_PHASE in timings, if given.
+	void scan(SourceFile& src, size_t threads, 
+		ScannerBackend backend, PassTimings * timings = nullptr);
+
+	//Write the buffer as a binary token dump
+	void write(std::ostream& out) const;
+	//True if the text looks like a binary token dump
+	static bool isDump(const char * data, size_t size);
+	//Fill an empty buffer from a binary token dump. Returns false
+	// if the dump is malformed.
+	bool load(const char * data, size_t size);
+
+	size_t size() const { return tokens.size(); }
+	const ScannedToken& at(size_t idx) const { return tokens[idx]; }
+	//The scanner's warnings and errors, in source order
+	const std::string& diagnostics() const { return diags; }
+private:
+	std::vector<ScannedToken> tokens;
+	std::string diags;
+	std::vector<Scanner *> scanners;
+	//Tokens created by load()
+	Arena loadArena;
+};
+
+} //End namespace lake
+
+#endif
@@ -13,18 +13,17 @@ namespace lake{
 		return _kind;
 	}
 
-	IDToken::IDToken(size_t ll, size_t cc, std::string value)
-	: Token(ll,cc,TokenKind::ID){
-		this->_value = value;
+	IDToken::IDToken(size_t ll, size_t cc, NameID id)
+	: Token(ll,cc,TokenKind::ID), _id(id){
 	}
 
 	IntLitToken::IntLitToken(size_t ll, size_t cc, int value)
 	: Token(ll,cc,TokenKind::INTLITERAL){
 		this->_value = value;
 	}
-	StringLitToken::StringLitToken(size_t ll, size_t cc, std::string value)
-	: Token(ll,cc,TokenKind::STRINGLITERAL)
+	StringLitToken::StringLitToken(size_t ll, size_t cc, 
+		const char * value, size_t len)
+	: Token(ll,cc,TokenKind::STRINGLITERAL), _text(value), _length(len)
 	{
-		this->_value = value;
 	}
 } // End namespace
@@ -2,10 +2,15 @@
 #define TEENC_TOKEN_H
 
 #include <iostream>
+#include "interner.hpp"
+#include "memstats.hpp"
 
 namespace lake{
 
-class Token {
+//Tokens are placed in the scanner's arena (see Scanner), so
+// they must not own any heap memory. IDs are interned, and the
+// text of string tokens points into that same arena.
+class Token : public MemCounted<TOKEN_ALLOC> {
 	public:
 		Token(size_t lineIn, size_t columnIn, int kind);
 		int kind();
@@ -33,18 +38,25 @@ class IntLitToken : public Token {
 
 class IDToken : public Token {
 	public:
-		IDToken(size_t line, size_t col, std::string id);
-		std::string value() { return _value; }
+		IDToken(size_t line, size_t col, NameID id);
+		const std::string& value() { return Interner::name(_id); }
+		NameID id() { return _id; }
+		//Give the token the ID of its name in another table
+		void rename(NameID id) { _id = id; }
 	private:
-		std::string _value;
+		NameID _id;
 };
 
 class StringLitToken : public Token {
 	public:
-		StringLitToken(size_t line, size_t col, std::string value);
-		std::string value() { return _value; }
+		StringLitToken(size_t line, size_t col, const char * value, 
+			size_t len);
+		std::string value() { return std::string(_text, _length); }
+		const char * text() { return _text; }
+		size_t length() { return _length; }
 	private:
-		std::string _value;
+		const char * _text;
+		size_t _length;
 };
 
 } //End namespace
@@ -1,17 +1,39 @@
+#include <algorithm>
 #include "ast.hpp"
 #include "symbol_table.hpp"
 #include "err.hpp"
+#include "flat_ast.hpp"
 #include "types.hpp"
 
 namespace lake{
 
+	//The table is sized for every node built so far the first time
+	// it is written, so that it grows at most rarely afterwards
+	void TypeAnalysis::nodeType(const ASTNode * node, TypeHandle type)
+	{
+		size_t id = node->getID();
+		if (id >= nodeTypes.size()){
+			nodeTypes.resize(std::max(ASTNode::idBound(), id + 1));
+		}
+		nodeTypes[id] = type;
+	}
+
+	TypeHandle TypeAnalysis::nodeType(const ASTNode * node){
+		size_t id = node->getID();
+		if (id >= nodeTypes.size() || nodeTypes[id].isNone()){
+			const char * msg = "No type for node ";
+			throw new InternalError(msg);
+		}
+		return nodeTypes[id];
+	}
+
 		// A good way to implement your type checker is by writing member functions for 
 		// the different subclasses of ASTNode. Your type checker should find all of the
 		// type errors described in the table of the project spec. Your type checker must
 		// report the specified position of the error, and it must give the specified error message. 
 
 	void ProgramNode::typeAnalysis(TypeAnalysis * ta){
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		//pass the TypeAnalysis down throughout
 		// the entire tree, getting the types for
@@ -21,32 +43,30 @@ namespace lake{
 
 		//The type of the program node will never
 		// be needed. We can just set it to VOID
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		//Alternatively, we could make our type 
 		// be error if the DeclListNode is an error
 
 		//Lookup the type assigned to the declList
 		// in the earlier recursive call
-		const DataType * childType = 
-			ta->nodeType(myDeclList);
-
-		//The asError() function of the DataType 
-		// class returns null (false) in every
-		// subclass EXCEPT for the ErrorType subclass,
-		// where it returns itself (non-null/true).
-		if (childType->asError()){
+		TypeHandle childType = ta->nodeType(myDeclList);
+
+		//The isError() test of a TypeHandle is
+		// false for every type EXCEPT the special
+		// error type.
+		if (childType.isError()){
 			//The child type is error, so 
 			// set the program node to error
 			// as well
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		}
 	}
 
 	void DeclListNode::typeAnalysis(TypeAnalysis * ta){
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
-		for (auto decl : *myDecls){
+		for (auto decl : myDecls){
 			//Do typeAnalysis on the single decl
 			decl->typeAnalysis(ta);
 
@@ -57,25 +77,25 @@ namespace lake{
 
 			//If the element type was the special
 			// "error" type, set this node to the errorType
-			if (eltType->asError()){
-				ta->nodeType(this, ErrorType::produce());
+			if (eltType.isError()){
+				ta->nodeType(this, TypeHandle::error());
 			}
 		}
 		return;
 	}
 
 	void FormalsListNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
-		ta->nodeType(this, getDeclaredType());
+		//A formals list is typed by its function
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 	}
 
 	void TypeNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
-		ta->nodeType(this, getDataType());
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
+		ta->nodeType(this, ta->handle(getDataType()));
 	}
 
 	void FnDeclNode::typeAnalysis(TypeAnalysis * ta){
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		//HINT: you might want to change the signature for
 		// typeAnalysis on FnBodyNode to take a second
@@ -90,15 +110,15 @@ namespace lake{
 		auto formalsType = ta->nodeType(myFormals);
 		auto bodyType = ta->nodeType(myBody);
 		
-		if (formalsType->asError() || bodyType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
+		if (formalsType.isError() || bodyType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, getDeclaredType());	
+			ta->nodeType(this, ta->handle(getDeclaredType()));
 		}
 	}
 
 	void FnBodyNode::typeAnalysis(TypeAnalysis * ta, FnType * fnType) {
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		//HINT: as above, you may want to pass the 
 		// fnDecl's type into the statement list as a 
@@ -113,14 +133,14 @@ namespace lake{
 		auto varDeclsType = ta->nodeType(myVarDecls);
 		auto myStmtListType = ta->nodeType(myStmtList);
 
-		if(varDeclsType->asError() || myStmtListType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
+		if(varDeclsType.isError() || myStmtListType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
 		}
 	}
 
 	void VarDeclListNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
-		for (auto varDecl : *myDecls) {
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
+		for (auto varDecl : myDecls) {
 			varDecl->typeAnalysis(ta);
 		}
 	}
@@ -129,41 +149,41 @@ namespace lake{
 
 		//Note, this function may need extra code
 
-		ta->nodeType(this, VarType::produce(VOID));
-		for (auto stmt : *myStmts) {
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
+		for (auto stmt : myStmts) {
 			stmt->typeAnalysis(ta, fnType);
 
 			auto stmtType = ta->nodeType(stmt);
 
-			if(stmtType->asError()) {
-				ta->nodeType(this, ErrorType::produce());
+			if(stmtType.isError()) {
+				ta->nodeType(this, TypeHandle::error());
 			}
 		}
 	}
 
 	void StmtNode::typeAnalysis(TypeAnalysis * ta, FnType * fnType) {
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		TODO("Implement me in the subclass");
 	}
 
 	void AssignStmtNode::typeAnalysis(TypeAnalysis * ta, FnType * fnType) {
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 
 		myAssign->typeAnalysis(ta);
 
 		//It can be a bit of a pain to write 
-		// "const DataType *" everywhere, so here
+		// "TypeHandle" everywhere, so here
 		// the use of auto is used instead to tell the
 		// compiler to figure out what the subType variable
 		// should be
 		auto subType = ta->nodeType(myAssign);
 
-		if (subType->asError()){
+		if (subType.isError()){
 			ta->nodeType(this, subType);
 		} else {
-			ta->nodeType(this, VarType::produce(VOID));
+			ta->nodeType(this, TypeHandle::var(VOID, 0));
 		}
 	}
 
@@ -172,7 +192,7 @@ namespace lake{
 	}
 
 	void AssignNode::typeAnalysis(TypeAnalysis * ta){
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		//TODO: Note that this function is incomplete. 
 		// and needs additional code
@@ -181,24 +201,24 @@ namespace lake{
 		myTgt->typeAnalysis(ta);
 		mySrc->typeAnalysis(ta);
 
-		const DataType * tgtType = ta->nodeType(myTgt);
-		const DataType * srcType = ta->nodeType(mySrc);
+		TypeHandle tgtType = ta->nodeType(myTgt);
+		TypeHandle srcType = ta->nodeType(mySrc);
 
-		if(tgtType->asError() || srcType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(srcType->asFn() && tgtType->asFn()) {
+		if(tgtType.isError() || srcType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(srcType.isFn() && tgtType.isFn()) {
 			ta->badAssignOpd(myTgt->getLine(), myTgt->getCol());
 			ta->badAssignOpd(mySrc->getLine(), mySrc->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(tgtType->asFn()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(tgtType.isFn()) {
 			ta->badAssignOpd(myTgt->getLine(), myTgt->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(srcType->asFn()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(srcType.isFn()) {
 			ta->badAssignOpd(mySrc->getLine(), mySrc->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else if(tgtType != srcType) {
 			ta->badAssignOpr(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
 			ta->nodeType(this, tgtType);
 			return;
@@ -206,13 +226,13 @@ namespace lake{
 	}
 
 	void DeclNode::typeAnalysis(TypeAnalysis * ta){
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		TODO("Override me in the subclass");
 	}
 
 	void VarDeclNode::typeAnalysis(TypeAnalysis * ta){
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		// VarDecls always pass type analysis, since they 
 		// are never used in an expression. You may choose
@@ -231,434 +251,434 @@ namespace lake{
 		// IDs never fail type analysis and always
 		// yield the type of their symbol (which
 		// depends on their definition)
-		ta->nodeType(this, this->getSymbol()->getType());
+		ta->nodeType(this, ta->handle(this->getSymbol()->getType()));
 	}
 
 	void IntNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(INT));
+		ta->nodeType(this, TypeHandle::var(INT, 0));
 	}
 
 	void IntLitNode::typeAnalysis(TypeAnalysis * ta){
 		// IntLits never fail their type analysis and always
 		// yield the type INT
-		ta->nodeType(this, VarType::produce(INT));
+		ta->nodeType(this, TypeHandle::var(INT, 0));
 	}
 
 	void BoolNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(BOOL));
+		ta->nodeType(this, TypeHandle::var(BOOL, 0));
 	}
 
 	void VoidNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 	}
 
 	void FalseNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(BOOL));
+		ta->nodeType(this, TypeHandle::var(BOOL, 0));
 	}
 
 	void TrueNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(BOOL));
+		ta->nodeType(this, TypeHandle::var(BOOL, 0));
 	}
 
 	void StrLitNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(STR));
+		ta->nodeType(this, TypeHandle::var(STR, 0));
 	}
 
 	void PlusNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 		myExp1->typeAnalysis(ta);
 		myExp2->typeAnalysis(ta);
 
-		const DataType * lType = ta->nodeType(myExp1);
-		const DataType * rType = ta->nodeType(myExp2);
+		TypeHandle lType = ta->nodeType(myExp1);
+		TypeHandle rType = ta->nodeType(myExp2);
 
-		if(lType->asError() || rType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt() && !rType->isInt()) {
+		if(lType.isError() || rType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt() && !rType.isInt()) {
 			ta->badMathOpd(myExp1->getLine(), myExp1->getCol());
 			ta->badMathOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt()) {
 			ta->badMathOpd(myExp1->getLine(), myExp1->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!rType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!rType.isInt()) {
 			ta->badMathOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		}else {
-			ta->nodeType(this, VarType::produce(INT));
+			ta->nodeType(this, TypeHandle::var(INT, 0));
 		}
 	}
 
 	void MinusNode::typeAnalysis(TypeAnalysis * ta) {
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		myExp1->typeAnalysis(ta);
 		myExp2->typeAnalysis(ta);
 
-		const DataType * lType = ta->nodeType(myExp1);
-		const DataType * rType = ta->nodeType(myExp2);
+		TypeHandle lType = ta->nodeType(myExp1);
+		TypeHandle rType = ta->nodeType(myExp2);
 
-		if(lType->asError() || rType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt() && !rType->isInt()) {
+		if(lType.isError() || rType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt() && !rType.isInt()) {
 			ta->badMathOpd(myExp1->getLine(), myExp1->getCol());
 			ta->badMathOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt()) {
 			ta->badMathOpd(myExp1->getLine(), myExp1->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!rType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!rType.isInt()) {
 			ta->badMathOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		}else {
-			ta->nodeType(this, VarType::produce(INT));
+			ta->nodeType(this, TypeHandle::var(INT, 0));
 		}
 	}
 
 	void TimesNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 		myExp1->typeAnalysis(ta);
 		myExp2->typeAnalysis(ta);
 
-		const DataType * lType = ta->nodeType(myExp1);
-		const DataType * rType = ta->nodeType(myExp2);
+		TypeHandle lType = ta->nodeType(myExp1);
+		TypeHandle rType = ta->nodeType(myExp2);
 
-		if(lType->asError() || rType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt() && !rType->isInt()) {
+		if(lType.isError() || rType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt() && !rType.isInt()) {
 			ta->badMathOpd(myExp1->getLine(), myExp1->getCol());
 			ta->badMathOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt()) {
 			ta->badMathOpd(myExp1->getLine(), myExp1->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!rType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!rType.isInt()) {
 			ta->badMathOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		}else {
-			ta->nodeType(this, VarType::produce(INT));
+			ta->nodeType(this, TypeHandle::var(INT, 0));
 		}
 	}
 
 	void DivideNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 		myExp1->typeAnalysis(ta);
 		myExp2->typeAnalysis(ta);
 
-		const DataType * lType = ta->nodeType(myExp1);
-		const DataType * rType = ta->nodeType(myExp2);
+		TypeHandle lType = ta->nodeType(myExp1);
+		TypeHandle rType = ta->nodeType(myExp2);
 
-		if(lType->asError() || rType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt() && !rType->isInt()) {
+		if(lType.isError() || rType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt() && !rType.isInt()) {
 			ta->badMathOpd(myExp1->getLine(), myExp1->getCol());
 			ta->badMathOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt()) {
 			ta->badMathOpd(myExp1->getLine(), myExp1->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!rType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!rType.isInt()) {
 			ta->badMathOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		}else {
-			ta->nodeType(this, VarType::produce(INT));
+			ta->nodeType(this, TypeHandle::var(INT, 0));
 		}
 	}
 
 	void AndNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 		myExp1->typeAnalysis(ta);
 		myExp2->typeAnalysis(ta);
 
-		const DataType * lType = ta->nodeType(myExp1);
-		const DataType * rType = ta->nodeType(myExp2);
+		TypeHandle lType = ta->nodeType(myExp1);
+		TypeHandle rType = ta->nodeType(myExp2);
 
-		if(lType->asError() || rType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isBool() || !rType->isBool()) {
+		if(lType.isError() || rType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isBool() || !rType.isBool()) {
 			ta->badLogicOpd(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(BOOL));
+			ta->nodeType(this, TypeHandle::var(BOOL, 0));
 		}
 	}
 
 	void OrNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 		myExp1->typeAnalysis(ta);
 		myExp2->typeAnalysis(ta);
 
-		const DataType * lType = ta->nodeType(myExp1);
-		const DataType * rType = ta->nodeType(myExp2);
+		TypeHandle lType = ta->nodeType(myExp1);
+		TypeHandle rType = ta->nodeType(myExp2);
 
-		if(lType->asError() || rType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isBool() || !rType->isBool()) {
+		if(lType.isError() || rType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isBool() || !rType.isBool()) {
 			ta->badLogicOpd(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(BOOL));
+			ta->nodeType(this, TypeHandle::var(BOOL, 0));
 		}
 	}
 
 	void EqualsNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 		myExp1->typeAnalysis(ta);
 		myExp2->typeAnalysis(ta);
 
-		const DataType * lType = ta->nodeType(myExp1);
-		const DataType * rType = ta->nodeType(myExp2);
+		TypeHandle lType = ta->nodeType(myExp1);
+		TypeHandle rType = ta->nodeType(myExp2);
 
-		if(lType->asError() || rType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(lType->asFn() || rType->asFn()) {
+		if(lType.isError() || rType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(lType.isFn() || rType.isFn()) {
 			ta->badEqOpd(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else if(lType != rType) {
 			ta->badEqOpr(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(BOOL));
+			ta->nodeType(this, TypeHandle::var(BOOL, 0));
 		}
 	}
 
 	void NotEqualsNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 		myExp1->typeAnalysis(ta);
 		myExp2->typeAnalysis(ta);
 
-		const DataType * lType = ta->nodeType(myExp1);
-		const DataType * rType = ta->nodeType(myExp2);
+		TypeHandle lType = ta->nodeType(myExp1);
+		TypeHandle rType = ta->nodeType(myExp2);
 
-		if(lType->asError() || rType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(lType->asFn() || rType->asFn()) {
+		if(lType.isError() || rType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(lType.isFn() || rType.isFn()) {
 			ta->badEqOpd(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else if(lType != rType) {
 			ta->badEqOpr(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(BOOL));
+			ta->nodeType(this, TypeHandle::var(BOOL, 0));
 		}
 	}
 
 	void LessNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 		myExp1->typeAnalysis(ta);
 		myExp2->typeAnalysis(ta);
 
-		const DataType * lType = ta->nodeType(myExp1);
-		const DataType * rType = ta->nodeType(myExp2);
+		TypeHandle lType = ta->nodeType(myExp1);
+		TypeHandle rType = ta->nodeType(myExp2);
 
-		if(lType->asError() || rType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt() && !rType->isInt()) {
+		if(lType.isError() || rType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt() && !rType.isInt()) {
 			ta->badRelOpd(myExp1->getLine(), myExp1->getCol());
 			ta->badRelOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt()) {
 			ta->badRelOpd(myExp1->getLine(), myExp1->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!rType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!rType.isInt()) {
 			ta->badRelOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(BOOL));
+			ta->nodeType(this, TypeHandle::var(BOOL, 0));
 		}
 	}
 
 	void GreaterNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 		myExp1->typeAnalysis(ta);
 		myExp2->typeAnalysis(ta);
 
-		const DataType * lType = ta->nodeType(myExp1);
-		const DataType * rType = ta->nodeType(myExp2);
+		TypeHandle lType = ta->nodeType(myExp1);
+		TypeHandle rType = ta->nodeType(myExp2);
 
-		if(lType->asError() || rType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt() && !rType->isInt()) {
+		if(lType.isError() || rType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt() && !rType.isInt()) {
 			ta->badRelOpd(myExp1->getLine(), myExp1->getCol());
 			ta->badRelOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt()) {
 			ta->badRelOpd(myExp1->getLine(), myExp1->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!rType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!rType.isInt()) {
 			ta->badRelOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(BOOL));
+			ta->nodeType(this, TypeHandle::var(BOOL, 0));
 		}
 	}
 
 	void LessEqNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 		myExp1->typeAnalysis(ta);
 		myExp2->typeAnalysis(ta);
 
-		const DataType * lType = ta->nodeType(myExp1);
-		const DataType * rType = ta->nodeType(myExp2);
+		TypeHandle lType = ta->nodeType(myExp1);
+		TypeHandle rType = ta->nodeType(myExp2);
 
-		if(lType->asError() || rType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt() && !rType->isInt()) {
+		if(lType.isError() || rType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt() && !rType.isInt()) {
 			ta->badRelOpd(myExp1->getLine(), myExp1->getCol());
 			ta->badRelOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt()) {
 			ta->badRelOpd(myExp1->getLine(), myExp1->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!rType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!rType.isInt()) {
 			ta->badRelOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(BOOL));
+			ta->nodeType(this, TypeHandle::var(BOOL, 0));
 		}
 	}
 
 	void GreaterEqNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 		myExp1->typeAnalysis(ta);
 		myExp2->typeAnalysis(ta);
 
-		const DataType * lType = ta->nodeType(myExp1);
-		const DataType * rType = ta->nodeType(myExp2);
+		TypeHandle lType = ta->nodeType(myExp1);
+		TypeHandle rType = ta->nodeType(myExp2);
 
-		if(lType->asError() || rType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt() && !rType->isInt()) {
+		if(lType.isError() || rType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt() && !rType.isInt()) {
 			ta->badRelOpd(myExp1->getLine(), myExp1->getCol());
 			ta->badRelOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!lType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!lType.isInt()) {
 			ta->badRelOpd(myExp1->getLine(), myExp1->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!rType->isInt()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!rType.isInt()) {
 			ta->badRelOpd(myExp2->getLine(), myExp2->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(BOOL));
+			ta->nodeType(this, TypeHandle::var(BOOL, 0));
 		}
 	}
 
 	void NotNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 		myExp->typeAnalysis(ta);
 
-		const DataType * type = ta->nodeType(myExp);
+		TypeHandle type = ta->nodeType(myExp);
 
-		if(type->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!type->isBool()) {
+		if(type.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!type.isBool()) {
 			ta->badLogicOpd(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(BOOL));
+			ta->nodeType(this, TypeHandle::var(BOOL, 0));
 		}
 	}
 
 	void PostDecStmtNode::typeAnalysis(TypeAnalysis * ta, FnType * fnType) {
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		myExp->typeAnalysis(ta);
 
-		const DataType * type = ta->nodeType(myExp);
+		TypeHandle type = ta->nodeType(myExp);
 
-		if(type->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!type->isInt()) {
+		if(type.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!type.isInt()) {
 			ta->badRelOpd(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(BOOL));
+			ta->nodeType(this, TypeHandle::var(BOOL, 0));
 		}
 	}
 
 	void PostIncStmtNode::typeAnalysis(TypeAnalysis * ta, FnType * fnType) {
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		myExp->typeAnalysis(ta);
 
-		const DataType * type = ta->nodeType(myExp);
+		TypeHandle type = ta->nodeType(myExp);
 
-		if(type->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!type->isInt()) {
+		if(type.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!type.isInt()) {
 			ta->badRelOpd(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(BOOL));
+			ta->nodeType(this, TypeHandle::var(BOOL, 0));
 		}
 	}
 
 	void ReadStmtNode::typeAnalysis(TypeAnalysis * ta, FnType * fnType) {
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		myExp->typeAnalysis(ta);
 
-		const DataType * type = ta->nodeType(myExp);
+		TypeHandle type = ta->nodeType(myExp);
 
-		if(type->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(type->isPtr()) {
+		if(type.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(type.isPtr()) {
 			ta->badReadPtr(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(type->asFn()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(type.isFn()) {
 			ta->readFn(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(VOID));
+			ta->nodeType(this, TypeHandle::var(VOID, 0));
 		}
 	}
 
 	void WriteStmtNode::typeAnalysis(TypeAnalysis * ta, FnType * fnType) {
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		myExp->typeAnalysis(ta);
 
-		const DataType * type = ta->nodeType(myExp);
+		TypeHandle type = ta->nodeType(myExp);
 
-		if(type->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(type->isPtr()) {
+		if(type.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(type.isPtr()) {
 			ta->writePtr(myExp->getLine(), myExp->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(type->isVoid()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(type.isVoid()) {
 			ta->badWriteVoid(myExp->getLine(), myExp->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(type->asFn()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(type.isFn()) {
 			ta->writeFn(myExp->getLine(), myExp->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(VOID));
+			ta->nodeType(this, TypeHandle::var(VOID, 0));
 		}
 	}
 
 	void IfStmtNode::typeAnalysis(TypeAnalysis * ta, FnType * fnType) {
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		myExp->typeAnalysis(ta);
 		myStmts->typeAnalysis(ta, fnType);
 		myDecls->typeAnalysis(ta);
 
-		const DataType * condType = ta->nodeType(myExp);
-		const DataType * myStmtsType = ta->nodeType(myExp);
-		const DataType * myDeclsType = ta->nodeType(myExp);
+		TypeHandle condType = ta->nodeType(myExp);
+		TypeHandle myStmtsType = ta->nodeType(myExp);
+		TypeHandle myDeclsType = ta->nodeType(myExp);
 
-		if(condType->asError() || myStmtsType->asError() || myDeclsType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!condType->isBool()) {
+		if(condType.isError() || myStmtsType.isError() || myDeclsType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!condType.isBool()) {
 			ta->badIfCond(myExp->getLine(), myExp->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(VOID));
+			ta->nodeType(this, TypeHandle::var(VOID, 0));
 		}
 	}
 
 	void IfElseStmtNode::typeAnalysis(TypeAnalysis * ta, FnType * fnType) {
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		myExp->typeAnalysis(ta);
 		myStmtsT->typeAnalysis(ta, fnType);
@@ -666,150 +686,565 @@ namespace lake{
 		myStmtsF->typeAnalysis(ta, fnType);
 		myDeclsF->typeAnalysis(ta);
 
-		const DataType * condType = ta->nodeType(myExp);
-		const DataType * myStmtsTypeT = ta->nodeType(myExp);
-		const DataType * myDeclsTypeT = ta->nodeType(myExp);
-		const DataType * myStmtsTypeF = ta->nodeType(myExp);
-		const DataType * myDeclsTypeF = ta->nodeType(myExp);
-
-		if(condType->asError() || myStmtsTypeT->asError() ||
-			myStmtsTypeF->asError() || myDeclsTypeF->asError()
-			|| myDeclsTypeT->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(condType->isBool()) {
+		TypeHandle condType = ta->nodeType(myExp);
+		TypeHandle myStmtsTypeT = ta->nodeType(myExp);
+		TypeHandle myDeclsTypeT = ta->nodeType(myExp);
+		TypeHandle myStmtsTypeF = ta->nodeType(myExp);
+		TypeHandle myDeclsTypeF = ta->nodeType(myExp);
+
+		if(condType.isError() || myStmtsTypeT.isError() ||
+			myStmtsTypeF.isError() || myDeclsTypeF.isError()
+			|| myDeclsTypeT.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(condType.isBool()) {
 			ta->badIfCond(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(VOID));
+			ta->nodeType(this, TypeHandle::var(VOID, 0));
 		}
 	}
 
 	void WhileStmtNode::typeAnalysis(TypeAnalysis * ta, FnType * fnType) {
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		myExp->typeAnalysis(ta);
 		myStmts->typeAnalysis(ta, fnType);
 		myDecls->typeAnalysis(ta);
 
-		const DataType * condType = ta->nodeType(myExp);
-		const DataType * myStmtsType = ta->nodeType(myExp);
-		const DataType * myDeclsType = ta->nodeType(myExp);
+		TypeHandle condType = ta->nodeType(myExp);
+		TypeHandle myStmtsType = ta->nodeType(myExp);
+		TypeHandle myDeclsType = ta->nodeType(myExp);
 
-		if(condType->asError() || myStmtsType->asError() || myDeclsType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(condType->isBool()) {
+		if(condType.isError() || myStmtsType.isError() || myDeclsType.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(condType.isBool()) {
 			ta->badWhileCond(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
-			ta->nodeType(this, VarType::produce(VOID));
+			ta->nodeType(this, TypeHandle::var(VOID, 0));
 		}
 	}
 
 	void CallStmtNode::typeAnalysis(TypeAnalysis * ta, FnType * fnType) {
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		myCallExp->typeAnalysis(ta);
 
-		const DataType * type = ta->nodeType(myCallExp);
+		TypeHandle type = ta->nodeType(myCallExp);
 
 		ta->nodeType(this, type);
 	}
 
 	void CallExpNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
 		myId->typeAnalysis(ta);
 		myExpList->typeAnalysis(ta);
 
-		auto idType = ta->nodeType(myId);
-		auto fnType = myId->getSymbol()->getType()->asFn();
-		auto expListType = ta->nodeType(myExpList);
-		auto type = ta->nodeType(myExpList);
+		TypeHandle fnType = ta->nodeType(myId);
 
-		if(fnType == nullptr) {
+		if(!fnType.isFn()) {
 			ta->badCallee(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 			return;
 		}
 
-		int actualsSize = expListType->asTuple()->getElts()->size();
-		int formalsSize = fnType->getFormalTypes()->getElts()->size();
-		std::string actuals = expListType->asTuple()->getString();
-		std::string formals = fnType->getFormalTypes()->getString();
+		//Actuals of error type are left out, and the rest must
+		// be the very types of the formals
+		auto actuals = myExpList->getExps();
+		size_t actualsSize = 0;
+		for(auto actual : actuals) {
+			if(!ta->nodeType(actual).isError()) { actualsSize++; }
+		}
+		size_t formalsSize = ta->formalsCount(fnType);
 
-		if(type->asError() || idType->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(actualsSize != formalsSize) {
+		if(actualsSize != formalsSize) {
 			ta->badArgCount(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(actuals != formals) {
-			ta->badArgMatch(myExpList->getExps()->front()->getLine(), myExpList->getExps()->front()->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(idType->asFn()) {
-			ta->nodeType(this, VarType::produce(VOID));
-		} else {
-			ta->badCallee(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
+			return;
 		}
+		const TypeHandle * formal = ta->formalsOf(fnType);
+		for(auto actual : actuals) {
+			TypeHandle actualType = ta->nodeType(actual);
+			if(actualType.isError()) { continue; }
+			if(actualType != *formal) {
+				ta->badArgMatch(actuals.front()->getLine(), actuals.front()->getCol());
+				ta->nodeType(this, TypeHandle::error());
+				return;
+			}
+			++formal;
+		}
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 	}
 
 	void ExpListNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
-		std::list<const DataType *> * expTypes = new std::list<const DataType *>();
-		for(auto exp : *myExps){
+		//An argument list is checked by its call
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
+		for(auto exp : myExps){
 			exp->typeAnalysis(ta);
-			const DataType * expType = ta->nodeType(exp);
-			if(expType->asError()){
-				ta->nodeType(this, ErrorType::produce());
-			} else {
-				expTypes->push_back(expType);
-			}
 		}
-		TupleType * expList = new TupleType(expTypes);
-		ta->nodeType(this, expList);
 	}
 
 	void ReturnStmtNode::typeAnalysis(TypeAnalysis * ta, FnType * fnType) {
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 
+		TypeHandle retType = ta->handle(fnType->getReturnType());
 		if(myExp == nullptr) {
-			if(!fnType->getReturnType()->isVoid()) {
+			if(!retType.isVoid()) {
 				ta->badNoRet(this->getLine(), this->getCol());
-				ta->nodeType(this, ErrorType::produce());
+				ta->nodeType(this, TypeHandle::error());
 				return;
 			} else {
-				ta->nodeType(this, VarType::produce(VOID));
+				ta->nodeType(this, TypeHandle::var(VOID, 0));
 				return;
 			}
 		}
 		myExp->typeAnalysis(ta);
-		const DataType * type = ta->nodeType(myExp);
-		const DataType * retType = fnType->getReturnType();
+		TypeHandle type = ta->nodeType(myExp);
 
-		if(type->asError()) {
-			ta->nodeType(this, ErrorType::produce());
-		} else if(retType->isVoid() && !type->isVoid()) {
+		if(type.isError()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(retType.isVoid() && !type.isVoid()) {
 			ta->extraRetValue(myExp->getLine(), myExp->getCol());
-			ta->nodeType(this, ErrorType::produce());
-		} else if(!retType->isVoid() && type->isVoid()) {
+			ta->nodeType(this, TypeHandle::error());
+		} else if(!retType.isVoid() && type.isVoid()) {
 			ta->badNoRet(myExp->getLine(), myExp->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else if(type != retType) {
 			ta->badRetValue(myExp->getLine(), myExp->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
 		} else {
 			ta->nodeType(this, type);
 		}
 	}
 
 	void DerefNode::typeAnalysis(TypeAnalysis * ta) { 
-		ta->nodeType(this, VarType::produce(VOID));
+		ta->nodeType(this, TypeHandle::var(VOID, 0));
 		myTgt->typeAnalysis(ta);
 		auto tgtType = ta->nodeType(myTgt);
-		if(!tgtType->isPtr())
+		if(!tgtType.isPtr())
 		{
 			ta->badDeref(this->getLine(), this->getCol());
-			ta->nodeType(this, ErrorType::produce());
+			ta->nodeType(this, TypeHandle::error());
+		}
+	}
+
+	TypeHandle TypeAnalysis::handle(const DataType * type) {
+		if(type == nullptr) {
+			return TypeHandle();
+		} else if(type->asError()) {
+			return TypeHandle::error();
+		} else if(const VarType * var = type->asVar()) {
+			if(var->getDepth() > TypeHandle::MAX_DEPTH) {
+				throw new InternalError("Pointer too deep for a handle");
+			}
+			return TypeHandle::var(var->getBaseType(), 
+				static_cast<uint32_t>(var->getDepth()));
+		}
+		const FnType * fnType = type->asFn();
+		if(fnType == nullptr) {
+			throw new InternalError("No handle for a tuple type");
+		}
+		auto found = signatureIDs.find(fnType);
+		if(found != signatureIDs.end()) {
+			return TypeHandle::fn(found->second);
+		}
+		if(signatures.size() == TypeHandle::MAX_SIGNATURES) {
+			throw new InternalError("Too many function types");
+		}
+		uint32_t id = static_cast<uint32_t>(signatures.size());
+		const std::vector<const DataType *>& formals =
+			fnType->getFormalTypes()->getElts();
+		Signature signature;
+		signature.type = fnType;
+		signature.formalsCount = formals.size();
+		//Converting a formal may add a signature of its own, so the
+		// formals are placed only once they are all converted
+		std::vector<TypeHandle> formalHandles;
+		for(const DataType * formal : formals) {
+			formalHandles.push_back(handle(formal));
+		}
+		signature.formalsStart = signatureFormals.size();
+		signatureFormals.insert(signatureFormals.end(),
+			formalHandles.begin(), formalHandles.end());
+		signatures.push_back(signature);
+		signatureIDs[fnType] = id;
+		return TypeHandle::fn(id);
+	}
+
+	const DataType * TypeAnalysis::dataType(TypeHandle handle) const {
+		if(handle.isNone()) {
+			return nullptr;
+		} else if(handle.isError()) {
+			return ErrorType::produce();
+		} else if(handle.isFn()) {
+			return signatures[handle.signature()].type;
+		}
+		return VarType::produce(handle.base(), handle.depth());
+	}
+
+	//The rules below are those of the typeAnalysis methods above,
+	// for the nodes of a FlatAST. Each takes the types already
+	// given to the node's children and returns the node's type.
+	// Types are handled as TypeHandles throughout.
+
+	static TypeHandle flatVar(BaseType base, uint32_t depth) {
+		if(depth > TypeHandle::MAX_DEPTH) {
+			throw new InternalError("Pointer too deep for a handle");
+		}
+		return TypeHandle::var(base, depth);
+	}
+
+	static TypeHandle flatMath(TypeAnalysis * ta, const FlatAST& ast,
+		const FlatRef * kids, TypeHandle lType, TypeHandle rType)
+	{
+		if(lType.isError() || rType.isError()) {
+			return TypeHandle::error();
+		}
+		if(lType.isInt() && rType.isInt()) {
+			return TypeHandle::var(INT, 0);
+		}
+		if(!lType.isInt()) {
+			ta->badMathOpd(ast.getLine(kids[0]), ast.getCol(kids[0]));
+		}
+		if(!rType.isInt()) {
+			ta->badMathOpd(ast.getLine(kids[1]), ast.getCol(kids[1]));
+		}
+		return TypeHandle::error();
+	}
+
+	static TypeHandle flatRelation(TypeAnalysis * ta, const FlatAST& ast,
+		const FlatRef * kids, TypeHandle lType, TypeHandle rType)
+	{
+		if(lType.isError() || rType.isError()) {
+			return TypeHandle::error();
+		}
+		if(lType.isInt() && rType.isInt()) {
+			return TypeHandle::var(BOOL, 0);
+		}
+		if(!lType.isInt()) {
+			ta->badRelOpd(ast.getLine(kids[0]), ast.getCol(kids[0]));
+		}
+		if(!rType.isInt()) {
+			ta->badRelOpd(ast.getLine(kids[1]), ast.getCol(kids[1]));
+		}
+		return TypeHandle::error();
+	}
+
+	static TypeHandle flatAssign(TypeAnalysis * ta, const FlatAST& ast,
+		FlatRef node, const FlatRef * kids,
+		TypeHandle tgtType, TypeHandle srcType)
+	{
+		if(tgtType.isError() || srcType.isError()) {
+			return TypeHandle::error();
+		}
+		if(tgtType.isFn() || srcType.isFn()) {
+			if(tgtType.isFn()) {
+				ta->badAssignOpd(ast.getLine(kids[0]), ast.getCol(kids[0]));
+			}
+			if(srcType.isFn()) {
+				ta->badAssignOpd(ast.getLine(kids[1]), ast.getCol(kids[1]));
+			}
+			return TypeHandle::error();
+		}
+		if(tgtType != srcType) {
+			ta->badAssignOpr(ast.getLine(node), ast.getCol(node));
+			return TypeHandle::error();
+		}
+		return tgtType;
+	}
+
+	//The type of a call. The arguments are matched against the
+	// formals the way ExpListNode and CallExpNode match them: actuals
+	// of error type are left out, and the rest must be the very types
+	// of the formals.
+	static TypeHandle flatCall(TypeAnalysis * ta, const FlatAST& ast,
+		FlatRef node, const FlatRef * kids,
+		const std::vector<TypeHandle>& types)
+	{
+		TypeHandle fnType = types[kids[0]];
+		if(!fnType.isFn()) {
+			ta->badCallee(ast.getLine(node), ast.getCol(node));
+			return TypeHandle::error();
+		}
+		FlatRef expList = kids[1];
+		const FlatRef * actuals = ast.childrenOf(expList);
+		size_t actualsCount = ast.childCount(expList);
+		size_t actualsSize = 0;
+		for(size_t i = 0; i < actualsCount; i++) {
+			if(!types[actuals[i]].isError()) { actualsSize++; }
+		}
+		if(actualsSize != ta->formalsCount(fnType)) {
+			ta->badArgCount(ast.getLine(node), ast.getCol(node));
+			return TypeHandle::error();
+		}
+		const TypeHandle * formal = ta->formalsOf(fnType);
+		for(size_t i = 0; i < actualsCount; i++) {
+			TypeHandle actual = types[actuals[i]];
+			if(actual.isError()) { continue; }
+			if(actual != *formal) {
+				ta->badArgMatch(ast.getLine(actuals[0]), ast.getCol(actuals[0]));
+				return TypeHandle::error();
+			}
+			++formal;
+		}
+		return TypeHandle::var(VOID, 0);
+	}
+
+	static TypeHandle flatReturn(TypeAnalysis * ta, const FlatAST& ast,
+		FlatRef node, const std::vector<TypeHandle>& types)
+	{
+		TypeHandle retType = types[ast.payload(node)];
+		if(ast.childCount(node) == 0) {
+			if(!retType.isVoid()) {
+				ta->badNoRet(ast.getLine(node), ast.getCol(node));
+				return TypeHandle::error();
+			}
+			return TypeHandle::var(VOID, 0);
+		}
+		FlatRef exp = ast.childrenOf(node)[0];
+		TypeHandle type = types[exp];
+		if(type.isError()) {
+			return TypeHandle::error();
+		} else if(retType.isVoid() && !type.isVoid()) {
+			ta->extraRetValue(ast.getLine(exp), ast.getCol(exp));
+			return TypeHandle::error();
+		} else if(!retType.isVoid() && type.isVoid()) {
+			ta->badNoRet(ast.getLine(exp), ast.getCol(exp));
+			return TypeHandle::error();
+		} else if(type != retType) {
+			ta->badRetValue(ast.getLine(exp), ast.getCol(exp));
+			return TypeHandle::error();
+		}
+		return type;
+	}
+
+	//The type of a statement or read/write operand
+	static TypeHandle flatStmt(TypeAnalysis * ta, const FlatAST& ast,
+		FlatRef node, NodeKind kind, FlatRef exp, TypeHandle type)
+	{
+		if(type.isError()) {
+			return TypeHandle::error();
+		}
+		switch(kind) {
+		case POST_INC_STMT_NODE:
+		case POST_DEC_STMT_NODE:
+			if(!type.isInt()) {
+				ta->badRelOpd(ast.getLine(node), ast.getCol(node));
+				return TypeHandle::error();
+			}
+			return TypeHandle::var(BOOL, 0);
+		case READ_STMT_NODE:
+			if(type.isPtr()) {
+				ta->badReadPtr(ast.getLine(node), ast.getCol(node));
+				return TypeHandle::error();
+			} else if(type.isFn()) {
+				ta->readFn(ast.getLine(node), ast.getCol(node));
+				return TypeHandle::error();
+			}
+			return TypeHandle::var(VOID, 0);
+		case WRITE_STMT_NODE:
+			if(type.isPtr()) {
+				ta->writePtr(ast.getLine(exp), ast.getCol(exp));
+				return TypeHandle::error();
+			} else if(type.isVoid()) {
+				ta->badWriteVoid(ast.getLine(exp), ast.getCol(exp));
+				return TypeHandle::error();
+			} else if(type.isFn()) {
+				ta->writeFn(ast.getLine(exp), ast.getCol(exp));
+				return TypeHandle::error();
+			}
+			return TypeHandle::var(VOID, 0);
+		case IF_STMT_NODE:
+			if(!type.isBool()) {
+				ta->badIfCond(ast.getLine(exp), ast.getCol(exp));
+				return TypeHandle::error();
+			}
+			return TypeHandle::var(VOID, 0);
+		case IF_ELSE_STMT_NODE:
+			if(type.isBool()) {
+				ta->badIfCond(ast.getLine(node), ast.getCol(node));
+				return TypeHandle::error();
+			}
+			return TypeHandle::var(VOID, 0);
+		case WHILE_STMT_NODE:
+			if(type.isBool()) {
+				ta->badWhileCond(ast.getLine(node), ast.getCol(node));
+				return TypeHandle::error();
+			}
+			return TypeHandle::var(VOID, 0);
+		default:
+			break;
+		}
+		throw new InternalError("Not a statement with an operand");
+	}
+
+	void TypeAnalysis::analyze(const FlatAST& ast) {
+		size_t count = ast.size();
+		flatTypes.assign(count, TypeHandle());
+		TypeHandle error = TypeHandle::error();
+		TypeHandle voidType = TypeHandle::var(VOID, 0);
+		size_t ids = 0;
+
+		//The tree walk throws when it reaches a unary minus, which
+		// has no type rule, before it looks at the operand. Stop at
+		// the same point: the start of the first such subtree.
+		FlatRef stop = static_cast<FlatRef>(count);
+		for(FlatRef node = 0; node < count; node++) {
+			if(ast.kind(node) == UNARY_MINUS_NODE) {
+				stop = std::min(stop, ast.subtreeStart(node));
+			}
+		}
+
+		for(FlatRef node = 0; node < count; node++) {
+			if(node == stop) {
+				TODO("Override me in the subclass");
+			}
+			const FlatRef * kids = ast.childrenOf(node);
+			NodeKind kind = ast.kind(node);
+			TypeHandle type = voidType;
+			switch(kind) {
+			case PROGRAM_NODE:
+			case DECL_LIST_NODE:
+			case FN_BODY_NODE:
+			case STMT_LIST_NODE:
+				//These fail if any child does
+				for(size_t i = 0; i < ast.childCount(node); i++) {
+					if(flatTypes[kids[i]].isError()) { type = error; }
+				}
+				break;
+			case VAR_DECL_LIST_NODE:
+			case VAR_DECL_NODE:
+			case FORMAL_DECL_NODE:
+			case FORMALS_LIST_NODE:
+			case EXP_LIST_NODE:
+				//A formals list is typed by its function, and an
+				// argument list is checked by its call
+				break;
+			case FN_DECL_NODE:
+				if(flatTypes[kids[3]].isError()) {
+					type = error;
+				} else {
+					type = flatTypes[kids[1]];
+				}
+				break;
+			case INT_NODE:
+				type = flatVar(INT, ast.payload(node));
+				break;
+			case BOOL_NODE:
+				type = flatVar(BOOL, ast.payload(node));
+				break;
+			case VOID_NODE:
+				type = flatVar(VOID, ast.payload(node));
+				break;
+			case ID_NODE:
+				type = handle(ast.symbolType(ids++));
+				break;
+			case INT_LIT_NODE:
+				type = TypeHandle::var(INT, 0);
+				break;
+			case STR_LIT_NODE:
+				type = TypeHandle::var(STR, 0);
+				break;
+			case TRUE_NODE:
+			case FALSE_NODE:
+				type = TypeHandle::var(BOOL, 0);
+				break;
+			case DEREF_NODE:
+				if(!flatTypes[kids[0]].isPtr()) {
+					badDeref(ast.getLine(node), ast.getCol(node));
+					type = error;
+				}
+				break;
+			case ASSIGN_NODE:
+				type = flatAssign(this, ast, node, kids,
+					flatTypes[kids[0]], flatTypes[kids[1]]);
+				break;
+			case CALL_EXP_NODE:
+				type = flatCall(this, ast, node, kids, flatTypes);
+				break;
+			case NOT_NODE:
+				if(flatTypes[kids[0]].isError()) {
+					type = error;
+				} else if(!flatTypes[kids[0]].isBool()) {
+					badLogicOpd(ast.getLine(node), ast.getCol(node));
+					type = error;
+				} else {
+					type = TypeHandle::var(BOOL, 0);
+				}
+				break;
+			case PLUS_NODE:
+			case MINUS_NODE:
+			case TIMES_NODE:
+			case DIVIDE_NODE:
+				type = flatMath(this, ast, kids,
+					flatTypes[kids[0]], flatTypes[kids[1]]);
+				break;
+			case AND_NODE:
+			case OR_NODE:
+				{
+				TypeHandle lType = flatTypes[kids[0]];
+				TypeHandle rType = flatTypes[kids[1]];
+				if(lType.isError() || rType.isError()) {
+					type = error;
+				} else if(!lType.isBool() || !rType.isBool()) {
+					badLogicOpd(ast.getLine(node), ast.getCol(node));
+					type = error;
+				} else {
+					type = TypeHandle::var(BOOL, 0);
+				}
+				break;
+				}
+			case EQUALS_NODE:
+			case NOT_EQUALS_NODE:
+				{
+				TypeHandle lType = flatTypes[kids[0]];
+				TypeHandle rType = flatTypes[kids[1]];
+				if(lType.isError() || rType.isError()) {
+					type = error;
+				} else if(lType.isFn() || rType.isFn()) {
+					badEqOpd(ast.getLine(node), ast.getCol(node));
+					type = error;
+				} else if(lType != rType) {
+					badEqOpr(ast.getLine(node), ast.getCol(node));
+					type = error;
+				} else {
+					type = TypeHandle::var(BOOL, 0);
+				}
+				break;
+				}
+			case LESS_NODE:
+			case GREATER_NODE:
+			case LESS_EQ_NODE:
+			case GREATER_EQ_NODE:
+				type = flatRelation(this, ast, kids,
+					flatTypes[kids[0]], flatTypes[kids[1]]);
+				break;
+			case ASSIGN_STMT_NODE:
+			case CALL_STMT_NODE:
+				type = flatTypes[kids[0]];
+				if(kind == ASSIGN_STMT_NODE && !type.isError()) {
+					type = voidType;
+				}
+				break;
+			case POST_INC_STMT_NODE:
+			case POST_DEC_STMT_NODE:
+			case READ_STMT_NODE:
+			case WRITE_STMT_NODE:
+			case IF_STMT_NODE:
+			case IF_ELSE_STMT_NODE:
+			case WHILE_STMT_NODE:
+				type = flatStmt(this, ast, node, kind,
+					kids[0], flatTypes[kids[0]]);
+				break;
+			case RETURN_STMT_NODE:
+				type = flatReturn(this, ast, node, flatTypes);
+				break;
+			case UNARY_MINUS_NODE:
+			case NUM_NODE_KINDS:
+				throw new InternalError("No flat type rule for node");
+			}
+			flatTypes[node] = type;
 		}
 	}
 }
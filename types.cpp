@@ -1,9 +1,87 @@
 #include "types.hpp"
 #include <list>
 #include <sstream>
+#include <utility>
 
 namespace lake{
 
+VarType * const * VarType::makeCommonTypes(){
+	static VarType * common[NUM_BASE_TYPES * COMMON_DEPTHS];
+	for (size_t base = 0 ; base < NUM_BASE_TYPES ; base++){
+		for (size_t depth = 0 ; depth < COMMON_DEPTHS ; depth++){
+			common[base * COMMON_DEPTHS + depth] = 
+				new VarType(static_cast<BaseType>(base), depth);
+		}
+	}
+	return common;
+}
+
+VarType * VarType::produceDeep(BaseType base, size_t depth){
+	static HashMap<size_t, VarType *> flyweights;
+	static std::mutex flyweightsLock;
+	std::lock_guard<std::mutex> guard(flyweightsLock);
+	size_t key = depth * NUM_BASE_TYPES + static_cast<size_t>(base);
+	auto found = flyweights.find(key);
+	if (found != flyweights.end()){ return found->second; }
+	VarType * newType = new VarType(base, depth);
+	flyweights[key] = newType;
+	return newType;
+}
+
+//Tuple and function types are looked up under a lock, since
+// several files may be analyzed at once. Finding a type that already
+// exists does not allocate.
+class TupleTypeHash{
+public:
+	size_t operator()(const std::vector<const DataType *>& elts) const {
+		size_t res = elts.size();
+		for (const DataType * elt : elts){
+			res = res * 31 + std::hash<const DataType *>()(elt);
+		}
+		return res;
+	}
+};
+
+TupleType * TupleType::produce(
+	const std::vector<const DataType *>& eltTypesIn)
+{
+	static std::unordered_map<std::vector<const DataType *>, 
+		TupleType *, TupleTypeHash> flyweights;
+	static std::mutex flyweightsLock;
+	std::lock_guard<std::mutex> guard(flyweightsLock);
+	auto found = flyweights.find(eltTypesIn);
+	if (found != flyweights.end()){ return found->second; }
+	TupleType * newType = new TupleType(eltTypesIn);
+	flyweights[eltTypesIn] = newType;
+	return newType;
+}
+
+class FnTypeHash{
+public:
+	size_t operator()(
+		const std::pair<const TupleType *, const DataType *>& key) const
+	{
+		return std::hash<const TupleType *>()(key.first) * 31 
+			+ std::hash<const DataType *>()(key.second);
+	}
+};
+
+FnType * FnType::produce(
+	const TupleType * formalsIn, const DataType * retTypeIn)
+{
+	static std::unordered_map<
+		std::pair<const TupleType *, const DataType *>, 
+		FnType *, FnTypeHash> flyweights;
+	static std::mutex flyweightsLock;
+	std::lock_guard<std::mutex> guard(flyweightsLock);
+	auto key = std::make_pair(formalsIn, retTypeIn);
+	auto found = flyweights.find(key);
+	if (found != flyweights.end()){ return found->second; }
+	FnType * newType = new FnType(formalsIn, retTypeIn);
+	flyweights[key] = newType;
+	return newType;
+}
+
 std::string VarType::getString() const{
 	std::string res = "";
 	switch(myBaseType){
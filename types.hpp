@@ -2,8 +2,11 @@
 #define LAKE_DATA_TYPES
 
 #include <list>
+#include <mutex>
 #include <sstream>
+#include <vector>
 #include "err.hpp"
+#include "memstats.hpp"
 
 #include <unordered_map>
 
@@ -18,6 +21,7 @@ using HashMap = std::unordered_map<K, V>;
 namespace lake{
 
 class ASTNode;
+class FlatAST;
 
 class VarType;
 class FnType;
@@ -73,7 +77,7 @@ private:
 };
 
 //DataType subclass for all scalar types 
-class VarType : public DataType{
+class VarType : public DataType, public MemCounted<VARTYPE_ALLOC>{
 public:
 	static VarType * produce(BaseType base){
 		return produce(base, 0);
@@ -89,7 +93,7 @@ public:
 	// and ensures that the memory needs of a program are kept
 	// down: rather than having a distinct type for every base
 	// INT (for example), only one is constructed and kept in
-	// the flyweights list. That type is then re-used anywhere
+	// the flyweights table. That type is then re-used anywhere
 	// it's needed. 
 
 	//Note the use of the static function declaration, which 
@@ -97,20 +101,17 @@ public:
 	// the function.
 	static VarType * produce(BaseType base, size_t depth){
 		//Note the use of the static local variable, which
-		//means that the flyweights variable persists between
-		// multiple calls to this function (it is essentially
-		// a global variable that can only be accessed
-		// in this function).
-		static std::list<VarType *> flyweights;
-		for(VarType * fly : flyweights){
-			if (fly->getDepth() == depth && 
-			    fly->getBaseType() == base){
-				return fly;
-			}
+		// is initialized on the first call only. C++ makes
+		// that first call thread-safe, and the table never
+		// changes after it, so every later lookup of a common
+		// type is a plain array read with no lock, even when
+		// several files are analyzed concurrently.
+		static VarType * const * common = makeCommonTypes();
+		if (depth < COMMON_DEPTHS){
+			size_t row = static_cast<size_t>(base) * COMMON_DEPTHS;
+			return common[row + depth];
 		}
-		VarType * newType = new VarType(base, depth);
-		flyweights.push_back(newType);
-		return newType;
+		return produceDeep(base, depth);
 	}
 	const VarType * asVar() const {
 		return this;
@@ -147,6 +148,13 @@ public:
 private:
 	VarType(BaseType base, size_t depth) 
 	: myBaseType(base), myDepth(depth){ }
+	//Every base type at each pointer depth below this is made up
+	// front, in a table indexed by base and then by depth
+	static const size_t COMMON_DEPTHS = 8;
+	static const size_t NUM_BASE_TYPES = static_cast<size_t>(STR) + 1;
+	static VarType * const * makeCommonTypes();
+	//Deeper pointer types are made on demand, under a lock
+	static VarType * produceDeep(BaseType base, size_t depth);
 	BaseType myBaseType;
 	size_t myDepth;
 };
@@ -154,16 +162,18 @@ private:
 // DataType subclass for tuples of types (i.e. lists of more
 // than 1 type. This is useful for expressing the types of 
 // formals lists and argument lists (and for matching them up)
-class TupleType : public DataType{
+class TupleType : public DataType, public MemCounted<TUPLETYPE_ALLOC>{
 public:
-	TupleType(std::list<const DataType *> * eltTypesIn)
-	: eltTypes(eltTypesIn){
-	}
-	DataType * data;
+	//Like VarType, tuples are flyweights: there is one instance
+	// for each list of element types, so two tuples match exactly
+	// when they are the same object. Since the element types are
+	// themselves flyweights, the list is hashed by address. 
+	static TupleType * produce(
+		const std::vector<const DataType *>& eltTypesIn);
 	std::string getString() const override{
 		std::string res = "";
 		bool first = true;
-		for (auto elt : *eltTypes){
+		for (auto elt : eltTypes){
 			if (first){ first = false; }
 			else { res += ","; }
 			res += elt->getString();
@@ -172,27 +182,26 @@ public:
 	}
 	virtual const TupleType * asTuple() const { return this; }
 
-	std::list<const DataType *> * getElts () const {
+	const std::vector<const DataType *>& getElts () const {
 		return eltTypes;
 	}
 private:
-	std::list<const DataType *> * eltTypes;
+	TupleType(const std::vector<const DataType *>& eltTypesIn)
+	: eltTypes(eltTypesIn){
+	}
+	std::vector<const DataType *> eltTypes;
 };
 
 
 //DataType subclass to represent the type of a function. It will
 // have a list of argument types and a return type. 
-class FnType : public DataType{
+class FnType : public DataType, public MemCounted<FNTYPE_ALLOC>{
 public:
-	FnType(const TupleType * formalsIn, const DataType * retTypeIn) 
-	: DataType(),
-	  myFormalTypes(formalsIn),
-	  myRetType(retTypeIn)
-	{
-	}
+	//The one function type with these formals and return type
+	static FnType * produce(
+		const TupleType * formalsIn, const DataType * retTypeIn);
 	std::string getString() const override{
 		std::string result = "";
-		bool first = true;
 		result += myFormalTypes->getString();
 		result += "->";
 		result += myRetType->getString();
@@ -207,16 +216,102 @@ public:
 		return myFormalTypes;
 	}
 private:
+	FnType(const TupleType * formalsIn, const DataType * retTypeIn) 
+	: DataType(),
+	  myFormalTypes(formalsIn),
+	  myRetType(retTypeIn)
+	{
+	}
 	const TupleType * myFormalTypes;
 	const DataType * myRetType;
 };
 
+//A type packed into one 32-bit word, for passes that look at many
+// types in a row. The low 2 bits say what kind of type it is. For a
+// scalar type, the next 2 bits are the base type and the rest are
+// the pointer depth, so the scalar predicates are a compare or two
+// on the word, with no pointer to follow and no virtual call. For a
+// function type, the rest is an index into a table of signatures
+// kept by whoever made the handle (see TypeAnalysis::handle). Two
+// handles from the same table are equal exactly when their
+// DataTypes are the same object.
+class TypeHandle{
+public:
+	//No type at all, as for an ID with no symbol
+	constexpr TypeHandle() : bits(NONE_KIND){ }
+	static constexpr TypeHandle var(BaseType base, uint32_t depth){
+		return TypeHandle(VAR_KIND 
+			| static_cast<uint32_t>(base) << KIND_BITS
+			| depth << DEPTH_SHIFT);
+	}
+	static constexpr TypeHandle fn(uint32_t signature){
+		return TypeHandle(FN_KIND | signature << KIND_BITS);
+	}
+	static constexpr TypeHandle error(){
+		return TypeHandle(ERROR_KIND);
+	}
+
+	constexpr bool isNone() const { return bits == NONE_KIND; }
+	constexpr bool isError() const { return bits == ERROR_KIND; }
+	constexpr bool isFn() const { return kind() == FN_KIND; }
+	constexpr bool isVar() const { return kind() == VAR_KIND; }
+	constexpr bool isInt() const { return bits == var(INT, 0).bits; }
+	constexpr bool isBool() const { return bits == var(BOOL, 0).bits; }
+	//Like VarType::isVoid, true of pointers to void as well
+	constexpr bool isVoid() const { 
+		return (bits & (KIND_MASK | BASE_MASK)) 
+			== var(BaseType::VOID, 0).bits;
+	}
+	constexpr bool isPtr() const { 
+		return isVar() && depth() > 0;
+	}
+
+	//Only meaningful for scalar types
+	constexpr BaseType base() const {
+		return static_cast<BaseType>((bits & BASE_MASK) >> KIND_BITS);
+	}
+	constexpr uint32_t depth() const { return bits >> DEPTH_SHIFT; }
+	//Only meaningful for function types
+	constexpr uint32_t signature() const { return bits >> KIND_BITS; }
+
+	constexpr bool operator==(TypeHandle other) const {
+		return bits == other.bits;
+	}
+	constexpr bool operator!=(TypeHandle other) const {
+		return bits != other.bits;
+	}
+
+	//The deepest pointer, and the most signatures, a handle holds
+	static const uint32_t MAX_DEPTH = (1u << (32 - 4)) - 1;
+	static const uint32_t MAX_SIGNATURES = (1u << (32 - 2));
+private:
+	constexpr explicit TypeHandle(uint32_t bitsIn) : bits(bitsIn){ }
+	constexpr uint32_t kind() const { return bits & KIND_MASK; }
+
+	static const uint32_t KIND_BITS = 2;
+	static const uint32_t DEPTH_SHIFT = 4;
+	static const uint32_t KIND_MASK = 0x3;
+	static const uint32_t BASE_MASK = 0xc;
+	static const uint32_t NONE_KIND = 0;
+	static const uint32_t VAR_KIND = 1;
+	static const uint32_t FN_KIND = 2;
+	static const uint32_t ERROR_KIND = 3;
+	uint32_t bits;
+};
+
+static_assert(sizeof(TypeHandle) == 4, "TypeHandle must be one word");
+static_assert(TypeHandle::var(INT, 0).isInt(), "int is int");
+static_assert(TypeHandle::var(BaseType::VOID, 2).isVoid(), 
+	"void@@ is void");
+static_assert(!TypeHandle::var(BOOL, 1).isBool(), "bool@ is not bool");
+static_assert(TypeHandle::var(STR, 3).depth() == 3, "depth round trips");
+
 // An instance of this class will be passed over the entire
 // AST. Rather than attaching types to each node, the 
 // TypeAnalysis class contains a map from each ASTNode to it's
-// DataType. Thus, instead of attaching a type field to most nodes,
-// one can instead map the node to it's type, or lookup the node
-// in the map.
+// type, kept as a TypeHandle. Thus, instead of attaching a type
+// field to most nodes, one can instead map the node to it's type,
+// or lookup the node in the map.
 class TypeAnalysis {
 public:
 	TypeAnalysis(){
@@ -232,21 +327,38 @@ public:
 
 	//Set the type of a node. Note that the function name is 
 	// overloaded: this 2-argument nodeType puts a value into the
-	// map with a given type. 
-	void nodeType(const ASTNode * node, const DataType * type){
-		nodeToType[node] = type;
-	}
+	// table with a given type. 
+	void nodeType(const ASTNode * node, TypeHandle type);
 
-	//Gets the type of a node already placed in the map. Note
+	//Gets the type of a node already placed in the table. Note
 	// that this function name is overloaded: the 1-argument nodeType
-	// gets the type of the given node out of the map.
-	const DataType * nodeType(const ASTNode * node){
-		const DataType * res = nodeToType[node];
-		if (res == nullptr){
-			const char * msg = "No type for node ";
-			throw new InternalError(msg);
-		}
-		return nodeToType[node];
+	// gets the type of the given node out of the table.
+	TypeHandle nodeType(const ASTNode * node);
+
+	//Type check a FlatAST, whose symbol types have been noted,
+	// in one pass over its arrays. Reports exactly the errors, in
+	// the same order, as typeAnalysis on the equivalent tree.
+	void analyze(const FlatAST& ast);
+
+	//The type given to a node of the last FlatAST analyzed
+	const DataType * flatNodeType(size_t node){
+		return dataType(flatTypes[node]);
+	}
+
+	//The handle of a type, for this analysis. A function type is
+	// given the next slot of the signature table the first time
+	// it is seen.
+	TypeHandle handle(const DataType * type);
+	//The type a handle of this analysis stands for, or null for
+	// the handle of no type
+	const DataType * dataType(TypeHandle handle) const;
+	//The formal types of the function type with the given handle
+	const TypeHandle * formalsOf(TypeHandle fnHandle) const {
+		return signatureFormals.data() 
+			+ signatures[fnHandle.signature()].formalsStart;
+	}
+	size_t formalsCount(TypeHandle fnHandle) const {
+		return signatures[fnHandle.signature()].formalsCount;
 	}
 
 	//The following functions all report and error and 
@@ -254,145 +366,158 @@ public:
 
 	void badArgMatch(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Type of actual does not match"
 			<< " type of formal\n";
 	}
 	void badMathOpd(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Arithmetic operator applied"
 			<< " to invalid operand\n";
 	}
 	void badMathOpr(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Arithmetic operator applied"
 			<< " to incompatible operands\n";
 	}
 	void badArgCount(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Function call with wrong"
 			<< " number of args\n";
 	}
 	void badCallee(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Attempt to call a "
 			<< "non-function\n";
 	}
 	void badAssignOpr(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Invalid assignment operation"
 			<< "\n";
 	}
 	void badAssignOpd(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Invalid assignment operand"
 			<< "\n";
 	}
 	void badDeref(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Invalid operand for deref"
 			<< "\n";
 	}
 	void badEqOpd(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Invalid equality operand"
 			<< "\n";
 	}
 	void badEqOpr(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Invalid equality operation"
 			<< "\n";
 	}
 	void badLogicOpd(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Logical operator applied to"
 			<< " non-bool operand"
 			<< "\n";
 	}
 	void badNoRet(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Missing return value"
 			<< "\n";
 	}
 	void badRelOpd(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Relational operator applied to"
 			<< " non-numeric operand"
 			<< "\n";
 	}
 	void badReadPtr(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Attempt to read a raw pointer"
 			<< "\n";
 	}
 	void badWriteVoid(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Attempt to write void"
 			<< "\n";
 	}
 
 	void badWhileCond(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Non-bool expression used as"
 			<< " a while condition"
 			<< "\n";
 	}
 	void badIfCond(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Non-bool expression used as"
 			<< " an if condition"
 			<< "\n";
 	}
 	void badRetValue(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Bad return value"
 			<< "\n";
 	}
 	void extraRetValue(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Return with a value in void"
 			<< " function"
 			<< "\n";
 	}
 	void writePtr(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Attempt to write a raw pointer"
 			<< "\n";
 	}
 	void writeFn(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Attempt to write a function"
 			<< "\n";
 	}
 	
 	void readFn(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		Err::out() << line << "," << col << ": "
 			<< "Attempt to read a function"
 			<< "\n";
 	}
 private:
-	HashMap<const ASTNode *, const DataType *> nodeToType;
+	//Node types, indexed by node ID
+	std::vector<TypeHandle> nodeTypes;
+	std::vector<TypeHandle> flatTypes;
+	//The function types handles have been made for, with their
+	// formals, which are kept one after another in signatureFormals
+	class Signature{
+	public:
+		const FnType * type;
+		size_t formalsStart;
+		size_t formalsCount;
+	};
+	std::vector<Signature> signatures;
+	std::vector<TypeHandle> signatureFormals;
+	HashMap<const FnType *, uint32_t> signatureIDs;
 	bool hasError;
 };
 
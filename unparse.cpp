@@ -1,271 +1,308 @@
 #include "ast.hpp"
+#include "ast_visitor.hpp"
 #include "symbol_table.hpp"
 
 namespace lake{
 
-void ProgramNode::unparse(std::ostream& out, int indent){
-	myDeclList->unparse(out, indent);
+//The text printed between the operands of a binary expression
+static const char * binaryOp(NodeKind kind){
+	switch(kind){
+		case PLUS_NODE: return "+";
+		case MINUS_NODE: return "-";
+		case TIMES_NODE: return "*";
+		case DIVIDE_NODE: return "/";
+		case AND_NODE: return " and ";
+		case OR_NODE: return " or ";
+		case EQUALS_NODE: return "==";
+		case NOT_EQUALS_NODE: return "!=";
+		case LESS_NODE: return "<";
+		case GREATER_NODE: return ">";
+		case LESS_EQ_NODE: return "<=";
+		case GREATER_EQ_NODE: return ">=";
+		default: break;
+	}
+	throw new InternalError("Not a binary operator");
 }
 
-void DeclListNode::unparse(std::ostream& out, int indent){
-	for (std::list<DeclNode *>::iterator 
-		it=myDecls->begin();
-		it != myDecls->end(); ++it){
-	    DeclNode * elt = *it;
-	    elt->unparse(out, indent);
+//Prints a tree back out as Lake source. Each node is printed at
+// the indent it is visited with.
+class Unparser : public ASTVisitor<Unparser>{
+public:
+	Unparser(std::ostream& outIn) : out(outIn), indent(0){ }
+
+	void unparse(ASTNode * node, int indentIn){
+		int outer = indent;
+		indent = indentIn;
+		visit(node);
+		indent = outer;
 	}
-}
 
-void VarDeclListNode::unparse(std::ostream& out, int indent){
-	for (VarDeclNode * varDecl : *myDecls){
-		varDecl->unparse(out, indent);
+	void visitProgramNode(ProgramNode * node){
+		unparse(node->getDeclList(), indent);
 	}
-}
 
-void FormalsListNode::unparse(std::ostream& out, int indent){
-	bool first = true;
-	for (FormalDeclNode * formal : *myFormals){
-		if (first){ first = false; }
-		else { out << ", "; }
-		formal->unparse(out, indent);
+	void visitDeclListNode(DeclListNode * node){
+		for (DeclNode * elt : node->getDecls()){
+			unparse(elt, indent);
+		}
 	}
-}
 
-void FnBodyNode::unparse(std::ostream& out, int indent){
-	this->doIndent(out, indent);
-	out << " {\n";
-	myVarDecls->unparse(out,indent+4);
-	myStmtList->unparse(out,indent+4);
-	out << "}\n";
-}
+	void visitVarDeclListNode(VarDeclListNode * node){
+		for (VarDeclNode * varDecl : node->getDecls()){
+			unparse(varDecl, indent);
+		}
+	}
 
-void ExpListNode::unparse(std::ostream& out, int indent){
-	bool first = true;
-	for (ExpNode * exp : *myExps){
-		if (first) { first = false; }
-		else { out << ","; }
-		exp->unparse(out, indent);
+	void visitFormalsListNode(FormalsListNode * node){
+		bool first = true;
+		for (FormalDeclNode * formal : node->getDecls()){
+			if (first){ first = false; }
+			else { out << ", "; }
+			unparse(formal, indent);
+		}
 	}
-}
 
-void StmtListNode::unparse(std::ostream& out, int indent){
-	for (std::list<StmtNode *>::iterator it=myStmts->begin();
-		it != myStmts->end(); ++it){
-	    StmtNode * elt = *it;
-	    elt->unparse(out, indent);
+	void visitFnBodyNode(FnBodyNode * node){
+		node->doIndent(out, indent);
+		out << " {\n";
+		unparse(node->getVarDecls(), indent+4);
+		unparse(node->getStmtList(), indent+4);
+		out << "}\n";
 	}
-}
 
-void VarDeclNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	getTypeNode()->unparse(out, 0);
-	out << " ";
-	out << getDeclaredName();
-	out << ";\n";
-}
+	void visitExpListNode(ExpListNode * node){
+		bool first = true;
+		for (ExpNode * exp : node->getExps()){
+			if (first) { first = false; }
+			else { out << ","; }
+			unparse(exp, indent);
+		}
+	}
 
-void FnDeclNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	getReturnTypeNode()->unparse(out, 0);
-	out << " ";
-	out << getDeclaredName();
-	out << "(";
-	myFormals->unparse(out, 0);
-	out << ")";
-	myBody->unparse(out, 0);
-}
+	void visitStmtListNode(StmtListNode * node){
+		for (StmtNode * elt : node->getStmts()){
+			unparse(elt, indent);
+		}
+	}
 
-void FormalDeclNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	getTypeNode()->unparse(out, 0);
-	out << " " << getDeclaredName();
-}
+	void visitVarDeclNode(VarDeclNode * node){
+		node->doIndent(out, indent);
+		unparse(node->getTypeNode(), 0);
+		out << " ";
+		out << node->getDeclaredName();
+		out << ";\n";
+	}
 
-void AssignStmtNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	myAssign->unparse(out,0);
-	out << ";\n";
-}
+	void visitFnDeclNode(FnDeclNode * node){
+		node->doIndent(out, indent);
+		unparse(node->getReturnTypeNode(), 0);
+		out << " ";
+		out << node->getDeclaredName();
+		out << "(";
+		unparse(node->getFormals(), 0);
+		out << ")";
+		unparse(node->getBody(), 0);
+	}
 
-void PostIncStmtNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	myExp->unparse(out,0);
-	out << "++;\n";
-}
+	void visitFormalDeclNode(FormalDeclNode * node){
+		node->doIndent(out, indent);
+		unparse(node->getTypeNode(), 0);
+		out << " " << node->getDeclaredName();
+	}
 
-void PostDecStmtNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	myExp->unparse(out,0);
-	out << "--;\n";
-}
+	void visitAssignStmtNode(AssignStmtNode * node){
+		node->doIndent(out, indent);
+		unparse(node->getAssign(), 0);
+		out << ";\n";
+	}
 
-void ReadStmtNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	out << ">> ";
-	myExp->unparse(out,0);
-	out << ";\n";
-}
+	void visitPostIncStmtNode(PostIncStmtNode * node){
+		node->doIndent(out, indent);
+		unparse(node->getExp(), 0);
+		out << "++;\n";
+	}
 
-void WriteStmtNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	out << "<< ";
-	myExp->unparse(out,0);
-	out << ";\n";
-}
+	void visitPostDecStmtNode(PostDecStmtNode * node){
+		node->doIndent(out, indent);
+		unparse(node->getExp(), 0);
+		out << "--;\n";
+	}
 
-void IfStmtNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	out << "if(";
-	myExp->unparse(out,0);
-	out << ") {\n";
-	myDecls->unparse(out,indent+4);
-	myStmts->unparse(out,indent+4);
-	doIndent(out, indent);
-	out << "}\n";
-}
+	void visitReadStmtNode(ReadStmtNode * node){
+		node->doIndent(out, indent);
+		out << ">> ";
+		unparse(node->getExp(), 0);
+		out << ";\n";
+	}
 
-void IfElseStmtNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	out << "if(";
-	myExp->unparse(out,0);
-	out << ") {\n";
-	myDeclsT->unparse(out,indent+4);
-	myStmtsT->unparse(out,indent+4);
-	doIndent(out, indent);
-	out << "}\n";
-	doIndent(out, indent);
-	out << "else {\n";
-	myDeclsF->unparse(out,indent+4);
-	myStmtsF->unparse(out,indent+4);
-	doIndent(out, indent);
-	out << "}\n";
-}
+	void visitWriteStmtNode(WriteStmtNode * node){
+		node->doIndent(out, indent);
+		out << "<< ";
+		unparse(node->getExp(), 0);
+		out << ";\n";
+	}
 
-void WhileStmtNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	out << "while(";
-	myExp->unparse(out,0);
-	out << ") {\n";
-	myDecls->unparse(out,indent+4);
-	myStmts->unparse(out,indent+4);
-	doIndent(out, indent);
-	out << "}\n";
-}
+	void visitIfStmtNode(IfStmtNode * node){
+		node->doIndent(out, indent);
+		out << "if(";
+		unparse(node->getExp(), 0);
+		out << ") {\n";
+		unparse(node->getDecls(), indent+4);
+		unparse(node->getStmts(), indent+4);
+		node->doIndent(out, indent);
+		out << "}\n";
+	}
 
-void CallStmtNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	myCallExp->unparse(out,0);
-	out << ";\n";
-}
+	void visitIfElseStmtNode(IfElseStmtNode * node){
+		node->doIndent(out, indent);
+		out << "if(";
+		unparse(node->getExp(), 0);
+		out << ") {\n";
+		unparse(node->getDeclsT(), indent+4);
+		unparse(node->getStmtsT(), indent+4);
+		node->doIndent(out, indent);
+		out << "}\n";
+		node->doIndent(out, indent);
+		out << "else {\n";
+		unparse(node->getDeclsF(), indent+4);
+		unparse(node->getStmtsF(), indent+4);
+		node->doIndent(out, indent);
+		out << "}\n";
+	}
 
-void ReturnStmtNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	out << "return ";
-	if(myExp != nullptr) {
-		myExp->unparse(out,0);
+	void visitWhileStmtNode(WhileStmtNode * node){
+		node->doIndent(out, indent);
+		out << "while(";
+		unparse(node->getExp(), 0);
+		out << ") {\n";
+		unparse(node->getDecls(), indent+4);
+		unparse(node->getStmts(), indent+4);
+		node->doIndent(out, indent);
+		out << "}\n";
 	}
-	out << ";\n";
-}
 
-void DerefNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	out << "@";
-	myTgt->unparse(out,0);
-}
+	void visitCallStmtNode(CallStmtNode * node){
+		node->doIndent(out, indent);
+		unparse(node->getCallExp(), 0);
+		out << ";\n";
+	}
 
-void IdNode::unparse(std::ostream& out, int indent){
-	if (indent < 0){ 
-		throw new InternalError("negative indent"); 
+	void visitReturnStmtNode(ReturnStmtNode * node){
+		node->doIndent(out, indent);
+		out << "return ";
+		if(node->getExp() != nullptr) {
+			unparse(node->getExp(), 0);
+		}
+		out << ";\n";
 	}
-	out << myStrVal;
-	if (mySymbol != NULL){
-		out << "(TODO)";
+
+	void visitDerefNode(DerefNode * node){
+		node->doIndent(out, indent);
+		out << "@";
+		unparse(node->getTgt(), 0);
 	}
-}
 
-void TypeNode::printIndirection(std::ostream& out){
-	int depth = getPtrDepth();
-	if (depth > 0){ out << " "; }
-	for (int i = 0 ; i < depth; i++){ out << "@"; }
-}
+	void visitIdNode(IdNode * node){
+		if (indent < 0){
+			throw new InternalError("negative indent");
+		}
+		out << node->getString();
+		if (node->getSymbol() != NULL){
+			out << "(TODO)";
+		}
+	}
 
-void IntNode::unparse(std::ostream& out, int indent){
-	if (indent < 0){ throw new InternalError("negative indent"); }
-	out << "int";
-	printIndirection(out);
-}
+	void visitIntNode(IntNode * node){
+		if (indent < 0){ throw new InternalError("negative indent"); }
+		out << "int";
+		node->printIndirection(out);
+	}
 
-void BoolNode::unparse(std::ostream& out, int indent){
-	if (indent < 0){ throw new InternalError("negative indent"); }
-	out << "bool";
-	printIndirection(out);
-}
+	void visitBoolNode(BoolNode * node){
+		if (indent < 0){ throw new InternalError("negative indent"); }
+		out << "bool";
+		node->printIndirection(out);
+	}
 
-void VoidNode::unparse(std::ostream& out, int indent){
-	if (indent < 0){ throw new InternalError("negative indent"); }
-	out << "void";
-	printIndirection(out);
-}
+	void visitVoidNode(VoidNode * node){
+		if (indent < 0){ throw new InternalError("negative indent"); }
+		out << "void";
+		node->printIndirection(out);
+	}
 
-void IntLitNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	out << myInt;
-}
+	void visitIntLitNode(IntLitNode * node){
+		node->doIndent(out, indent);
+		out << node->getValue();
+	}
 
-void StrLitNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	out << myString;
-}
+	void visitStrLitNode(StrLitNode * node){
+		node->doIndent(out, indent);
+		out.write(node->getText(),
+			static_cast<std::streamsize>(node->getLength()));
+	}
 
-void TrueNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	out << "true";
-}
+	void visitTrueNode(TrueNode * node){
+		node->doIndent(out, indent);
+		out << "true";
+	}
 
-void FalseNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	out << "false";
-}
+	void visitFalseNode(FalseNode * node){
+		node->doIndent(out, indent);
+		out << "false";
+	}
 
-void AssignNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	myTgt->unparse(out, 0);
-	out << " = ";
-	mySrc->unparse(out, 0);
-}
+	void visitAssignNode(AssignNode * node){
+		node->doIndent(out, indent);
+		unparse(node->getTgt(), 0);
+		out << " = ";
+		unparse(node->getSrc(), 0);
+	}
 
-void CallExpNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	myId->unparse(out, 0);
-	out << "(";
-	myExpList->unparse(out, 0);
-	out << ")";
-}
+	void visitCallExpNode(CallExpNode * node){
+		node->doIndent(out, indent);
+		unparse(node->getId(), 0);
+		out << "(";
+		unparse(node->getExpList(), 0);
+		out << ")";
+	}
 
-void UnaryMinusNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	out << "(";
-	out << "-";
-	myExp->unparse(out, 0);
-	out << ")";
-}
+	void visitUnaryMinusNode(UnaryMinusNode * node){
+		node->doIndent(out, indent);
+		out << "(";
+		out << "-";
+		unparse(node->getExp(), 0);
+		out << ")";
+	}
 
-void NotNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	out << "(";
-	out << "!";
-	myExp->unparse(out, 0);
-	out << ")";
-}
+	void visitNotNode(NotNode * node){
+		node->doIndent(out, indent);
+		out << "(";
+		out << "!";
+		unparse(node->getExp(), 0);
+		out << ")";
+	}
 
-void BinaryExpNode::unparse(std::ostream& out, int indent){
-	doIndent(out, indent);
-	out << "(";
-	myExp1->unparse(out, 0);
-	out << myOp();
-	myExp2->unparse(out, 0);
-	out << ")";
+	void visitBinaryExpNode(BinaryExpNode * node){
+		node->doIndent(out, indent);
+		out << "(";
+		unparse(node->getExp1(), 0);
+		out << binaryOp(node->getKind());
+		unparse(node->getExp2(), 0);
+		out << ")";
+	}
+private:
+	std::ostream& out;
+	int indent;
+};
+
+void ASTNode::unparse(std::ostream& out, int indent){
+	Unparser(out).unparse(this, indent);
 }
 
+void TypeNode::printIndirection(std::ostream& out){
+	int depth = getPtrDepth();
+	if (depth > 0){ out << " "; }
+	for (int i = 0 ; i < depth; i++){ out << "@"; }
+}
 
 } // End namespace LIL' C